@@ -0,0 +1,96 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "shared_ptr.h"
+
+//Reader scalability of AtomicSharedPtr::load against SharedPtr guarded by std::mutex
+//N readers copy published pointer as fast as they can for fixed time,
+//one writer publishes new object every millisecond
+//usage: atomic_shared_ptr_benchmark [max_readers] [milliseconds]
+
+struct Config {
+	int value;
+	explicit Config(int value_tmp) : value(value_tmp) {}
+};
+
+class MutexSharedPtr {
+	//the simple way to publish SharedPtr between threads
+	mutable std::mutex mutex;
+	SharedPtr<Config> value;
+
+public:
+	MutexSharedPtr(const SharedPtr<Config>& value_tmp) : value(value_tmp) {}
+
+	SharedPtr<Config> load() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return value;
+	}
+
+	void store(const SharedPtr<Config>& value_tmp) {
+		std::lock_guard<std::mutex> lock(mutex);
+		value = value_tmp;
+	}
+};
+
+template <class Published>
+double loads_per_second(Published& published, int readers, int milliseconds) {
+	std::atomic<bool> stop(false);
+	std::atomic<long long> total_loads(0);
+	std::atomic<long long> checksum(0);
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < readers; ++i) {
+		threads.emplace_back([&] {
+			long long loads = 0;
+			long long sum = 0;
+			while (!stop.load(std::memory_order_relaxed)) {
+				SharedPtr<Config> config = published.load();
+				sum += config->value;
+				++loads;
+			}
+			total_loads += loads;
+			checksum += sum;
+		});
+	}
+	threads.emplace_back([&] {
+		for (int i = 1; !stop.load(std::memory_order_relaxed); ++i) {
+			published.store(makeShared<Config>(i));
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	});
+
+	auto begin = std::chrono::steady_clock::now();
+	std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+	stop = true;
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	if (checksum.load() < 0) {
+		std::printf("bad checksum\n");
+	}
+	return total_loads.load() / seconds;
+}
+
+int main(int argc, char** argv) {
+	int max_readers = argc > 1 ? std::atoi(argv[1]) : static_cast<int>(std::thread::hardware_concurrency());
+	int milliseconds = argc > 2 ? std::atoi(argv[2]) : 500;
+	if (max_readers < 1) {
+		max_readers = 1;
+	}
+
+	std::printf("%8s %20s %20s %8s\n", "readers", "AtomicSharedPtr/s", "mutex+SharedPtr/s", "ratio");
+	for (int readers = 1; readers <= max_readers; readers *= 2) {
+		AtomicSharedPtr<Config> atomic_published(makeShared<Config>(0));
+		MutexSharedPtr mutex_published(makeShared<Config>(0));
+		double atomic_rate = loads_per_second(atomic_published, readers, milliseconds);
+		double mutex_rate = loads_per_second(mutex_published, readers, milliseconds);
+		std::printf("%8d %20.0f %20.0f %8.2f\n", readers, atomic_rate, mutex_rate, atomic_rate / mutex_rate);
+	}
+	return 0;
+}
@@ -0,0 +1,90 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "shared_ptr.h"
+
+//Calls of operator new made by adopting constructors of SharedPtr with and without ControlBlockPool
+//SharedPtr(ptr, deleter) takes control block from pool,
+//SharedPtr(ptr, deleter, std::allocator) allocates it by operator new every time
+//objects are elements of static array with empty deleter, so only control blocks are counted
+//usage: control_block_pool_benchmark [objects] [rounds]
+
+static size_t number_of_new = 0;
+
+void* operator new(size_t size) {
+	++number_of_new;
+	void* memory = std::malloc(size == 0 ? 1 : size);
+	if (memory == nullptr) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+	std::free(memory);
+}
+
+struct EmptyDeleter {
+	void operator()(int*) const {}
+};
+
+struct RoundResult {
+	size_t number_of_new;
+	double seconds;
+};
+
+template <class MakePointer>
+RoundResult run_round(std::vector<SharedPtr<int>>& pointers, size_t objects, MakePointer make_pointer) {
+	//pointers has capacity for all objects, so vector does not call operator new
+	size_t new_before = number_of_new;
+	auto begin = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < objects; ++i) {
+		pointers.push_back(make_pointer(i));
+	}
+	pointers.clear();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	return {number_of_new - new_before, seconds};
+}
+
+int main(int argc, char** argv) {
+	size_t objects = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000;
+	int rounds = argc > 2 ? std::atoi(argv[2]) : 1000;
+	std::vector<int> values(objects);
+	std::vector<SharedPtr<int>> pointers;
+	pointers.reserve(objects);
+
+	auto with_pool = [&values](size_t i) {
+		return SharedPtr<int>(&values[i], EmptyDeleter());
+	};
+	auto without_pool = [&values](size_t i) {
+		return SharedPtr<int>(&values[i], EmptyDeleter(), std::allocator<int>());
+	};
+
+	std::printf("%zu objects, %d rounds of create and destroy\n", objects, rounds);
+	std::printf("%-16s %16s %16s %12s\n", "", "new, 1st round", "new, per round", "seconds");
+	const std::pair<const char*, bool> modes[] = {{"pool", true}, {"operator new", false}};
+	for (const auto& mode : modes) {
+		RoundResult first = mode.second ? run_round(pointers, objects, with_pool) :
+				run_round(pointers, objects, without_pool);
+		size_t total_new = 0;
+		double total_seconds = 0;
+		for (int round = 1; round < rounds; ++round) {
+			RoundResult result = mode.second ? run_round(pointers, objects, with_pool) :
+					run_round(pointers, objects, without_pool);
+			total_new += result.number_of_new;
+			total_seconds += result.seconds;
+		}
+		double per_round = rounds > 1 ? static_cast<double>(total_new) / (rounds - 1) : 0;
+		std::printf("%-16s %16zu %16.1f %12.4f\n", mode.first, first.number_of_new, per_round,
+				total_seconds + first.seconds);
+	}
+	return 0;
+}
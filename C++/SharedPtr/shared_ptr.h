@@ -1,9 +1,24 @@
 #pragma once
 #include <memory>
+#include <deque>
+#include <atomic>
+#include <cstdint>
 
 #include <iostream>
 #include <cassert>
 
+#ifdef SHARED_PTR_INSTRUMENTATION
+#include <execinfo.h>
+#include <cxxabi.h>
+#include <cstdlib>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <vector>
+#endif
+
 //This structures are helpers for class SharedPtr and class WeakPtr
 //They does not depend of T than they defined without class SharedPtr and class WeakPtr
 
@@ -17,9 +32,187 @@
 
 //Allocator can have any type as parameter
 
+//Instrumentation:
+//build with -DSHARED_PTR_INSTRUMENTATION to collect statistics for each type T of SharedPtr<T>
+//statistics: control block allocations, makeShared and adopt, live and peak live objects,
+//copies and moves, failed WeakPtr::lock
+//every kCopySamplePeriod-th copy saves its call stack, the hottest stacks are shown in the report
+//report is written to std::cerr at exit
+//without this flag all hooks are empty
+
+#ifdef SHARED_PTR_INSTRUMENTATION
+
+struct SharedPtrTypeStatistics {
+	static const size_t kCopySamplePeriod = 64;
+	static const int kStackDepth = 8;
+
+	std::string type_name;
+	std::atomic<size_t> control_block_allocations{0};
+	std::atomic<size_t> make_shared{0};
+	std::atomic<size_t> adopt{0};
+	std::atomic<size_t> live{0};
+	std::atomic<size_t> peak_live{0};
+	std::atomic<size_t> copies{0};
+	std::atomic<size_t> moves{0};
+	std::atomic<size_t> failed_weak_locks{0};
+
+	std::mutex copy_sites_mutex;
+	std::map<std::vector<void*>, size_t> copy_sites;
+	//sampled call stack of copy and number of samples
+
+	SharedPtrTypeStatistics(const char* mangled_name) {
+		int status = 0;
+		char* demangled_name = abi::__cxa_demangle(mangled_name, nullptr, nullptr, &status);
+		type_name = (status == 0) ? demangled_name : mangled_name;
+		std::free(demangled_name);
+	}
+
+	void add_live() {
+		size_t live_tmp = ++live;
+		size_t peak_live_tmp = peak_live;
+		while (live_tmp > peak_live_tmp &&
+				!peak_live.compare_exchange_weak(peak_live_tmp, live_tmp)) {}
+	}
+
+	void add_copy() {
+		if (copies++ % kCopySamplePeriod != 0) {
+			return;
+		}
+		void* frames[kStackDepth];
+		int depth = backtrace(frames, kStackDepth);
+		std::vector<void*> stack(frames, frames + depth);
+		std::lock_guard<std::mutex> lock(copy_sites_mutex);
+		++copy_sites[stack];
+	}
+
+	void report(std::ostream& os) {
+		os << "SharedPtr<" << type_name << ">\n";
+		os << "  control blocks: " << control_block_allocations
+				<< " (makeShared " << make_shared << ", adopt " << adopt << ")\n";
+		os << "  live: " << live << ", peak live: " << peak_live << '\n';
+		os << "  copies: " << copies << ", moves: " << moves << '\n';
+		os << "  failed weak locks: " << failed_weak_locks << '\n';
+
+		std::lock_guard<std::mutex> lock(copy_sites_mutex);
+		std::vector<std::pair<size_t, std::vector<void*>>> hottest;
+		for (const auto& site: copy_sites) {
+			hottest.push_back({site.second, site.first});
+		}
+		std::sort(hottest.begin(), hottest.end(), [](const auto& left, const auto& right) {
+			return left.first > right.first;
+		});
+		for (size_t i = 0; i < hottest.size() && i < 3; ++i) {
+			os << "  copy site sampled " << hottest[i].first << " times:\n";
+			std::vector<void*>& stack = hottest[i].second;
+			char** symbols = backtrace_symbols(stack.data(), static_cast<int>(stack.size()));
+			for (size_t j = 0; j < stack.size(); ++j) {
+				os << "    " << ((symbols != nullptr) ? symbols[j] : "?") << '\n';
+			}
+			std::free(symbols);
+		}
+	}
+};
+
+struct SharedPtrStatistics {
+	std::mutex types_mutex;
+	std::vector<SharedPtrTypeStatistics*> types;
+
+	struct Reporter {
+		SharedPtrStatistics* statistics;
+
+		~Reporter() {
+			statistics->report(std::cerr);
+		}
+	};
+
+	static SharedPtrStatistics& instance() {
+		//statistics are never destroyed, so SharedPtr destroyed after report can still use them
+		static SharedPtrStatistics* statistics = new SharedPtrStatistics();
+		static Reporter reporter{statistics};
+		return *statistics;
+	}
+
+	SharedPtrTypeStatistics* register_type(const char* mangled_name) {
+		SharedPtrTypeStatistics* type_statistics = new SharedPtrTypeStatistics(mangled_name);
+		std::lock_guard<std::mutex> lock(types_mutex);
+		types.push_back(type_statistics);
+		return type_statistics;
+	}
+
+	void report(std::ostream& os) {
+		std::lock_guard<std::mutex> lock(types_mutex);
+		os << "SharedPtr instrumentation report\n";
+		for (SharedPtrTypeStatistics* type_statistics: types) {
+			type_statistics->report(os);
+		}
+	}
+};
+
+#endif
+
+//Counters are atomic: copies of one SharedPtr can be made and destroyed in different threads
+//WeakPtr is not thread-safe yet
+
 struct Count {
-	size_t shared_ptr_count;
-	size_t weak_ptr_count;
+	std::atomic<size_t> shared_ptr_count;
+	std::atomic<size_t> weak_ptr_count;
+#ifdef SHARED_PTR_INSTRUMENTATION
+	SharedPtrTypeStatistics* statistics = nullptr;
+	//statistics of type which created object
+#endif
+
+	Count(size_t shared_ptr_count_tmp, size_t weak_ptr_count_tmp) :
+		shared_ptr_count(shared_ptr_count_tmp),
+		weak_ptr_count(weak_ptr_count_tmp)
+	{}
+};
+
+template <typename T>
+struct SharedPtrInstrumentation {
+#ifdef SHARED_PTR_INSTRUMENTATION
+	static SharedPtrTypeStatistics* statistics() {
+		static SharedPtrTypeStatistics* type_statistics =
+				SharedPtrStatistics::instance().register_type(typeid(T).name());
+		return type_statistics;
+	}
+
+	static void on_construct(Count* count, bool in_place) {
+		count->statistics = statistics();
+		++count->statistics->control_block_allocations;
+		if (in_place) {
+			++count->statistics->make_shared;
+		} else {
+			++count->statistics->adopt;
+		}
+		count->statistics->add_live();
+	}
+
+	static void on_object_destroyed(Count* count) {
+		--count->statistics->live;
+	}
+
+	static void on_copy() {
+		statistics()->add_copy();
+	}
+
+	static void on_move() {
+		++statistics()->moves;
+	}
+
+	static void on_failed_weak_lock() {
+		++statistics()->failed_weak_locks;
+	}
+#else
+	static void on_construct(Count*, bool) {}
+
+	static void on_object_destroyed(Count*) {}
+
+	static void on_copy() {}
+
+	static void on_move() {}
+
+	static void on_failed_weak_lock() {}
+#endif
 };
 
 struct DestructorDeleter {
@@ -233,6 +426,203 @@ struct RealAllocator : public BaseRealAllocator {
 	~RealAllocator() override {}
 };
 
+//Pool for memory of control blocks:
+//SharedPtr(ptr) and SharedPtr(ptr, deleter) allocate only RealAllocator, Count and ControlBlock
+//this memory is rounded up to size class (multiple of kStep) and taken from free list of this class
+//each thread keeps its own free lists, so allocate and deallocate do not take locks
+//memory returns to free list of thread which made final release
+//big blocks and blocks over kMaxCachedBlocks go to operator new and operator delete
+
+struct ControlBlockPool {
+	static const size_t kStep = 16;
+	static const size_t kNumberOfClasses = 16;
+	static const size_t kMaxCachedBlocks = 1024;
+
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	FreeBlock* free_lists[kNumberOfClasses] = {};
+	size_t number_of_cached[kNumberOfClasses] = {};
+	bool finished = false;
+	//thread is finishing, memory is not cached any more
+
+	struct Cleaner {
+		ControlBlockPool* pool;
+
+		~Cleaner() {
+			pool->finished = true;
+			pool->release_all();
+		}
+	};
+
+	static ControlBlockPool& instance() {
+		//pool itself is never destroyed, so SharedPtr destroyed after thread-local objects can still use it
+		thread_local ControlBlockPool pool;
+		thread_local Cleaner cleaner{&pool};
+		return pool;
+	}
+
+	static size_t size_class(size_t bytes) {
+		assert(bytes > 0);
+		return (bytes - 1) / kStep;
+	}
+
+	char* allocate(size_t bytes) {
+		size_t index = size_class(bytes);
+		if (index >= kNumberOfClasses) {
+			return static_cast<char*>(::operator new(bytes));
+		}
+		FreeBlock* block = free_lists[index];
+		if (block == nullptr) {
+			return static_cast<char*>(::operator new((index + 1) * kStep));
+		}
+		free_lists[index] = block->next;
+		--number_of_cached[index];
+		return reinterpret_cast<char*>(block);
+	}
+
+	void deallocate(char* memory, size_t bytes) {
+		size_t index = size_class(bytes);
+		if (finished || index >= kNumberOfClasses || number_of_cached[index] == kMaxCachedBlocks) {
+			::operator delete(memory);
+			return;
+		}
+		FreeBlock* block = reinterpret_cast<FreeBlock*>(memory);
+		block->next = free_lists[index];
+		free_lists[index] = block;
+		++number_of_cached[index];
+	}
+
+	void release_all() {
+		for (size_t i = 0; i < kNumberOfClasses; ++i) {
+			while (free_lists[i] != nullptr) {
+				FreeBlock* block = free_lists[i];
+				free_lists[i] = block->next;
+				::operator delete(block);
+			}
+			number_of_cached[i] = 0;
+		}
+	}
+};
+
+template <typename T>
+struct ControlBlockPoolAllocator {
+	//allocator for control blocks, used if user does not give his own allocator
+	using value_type = T;
+
+	ControlBlockPoolAllocator() {}
+
+	template <typename U>
+	ControlBlockPoolAllocator(const ControlBlockPoolAllocator<U>&) {}
+
+	T* allocate(size_t n) {
+		return reinterpret_cast<T*>(ControlBlockPool::instance().allocate(n * sizeof(T)));
+	}
+
+	void deallocate(T* memory, size_t n) {
+		ControlBlockPool::instance().deallocate(reinterpret_cast<char*>(memory), n * sizeof(T));
+	}
+
+	template <typename U>
+	bool operator==(const ControlBlockPoolAllocator<U>&) const {
+		return true;
+	}
+
+	template <typename U>
+	bool operator!=(const ControlBlockPoolAllocator<U>&) const {
+		return false;
+	}
+};
+
+//Deferred release:
+//by default last SharedPtr destroys object and frees memory on the caller's thread
+//if deferred mode is on for this thread, last SharedPtr only puts ControlBlock and RealAllocator in the queue
+//objects from the queue are destroyed by drainReleaseQueue(budget), at most budget objects per call
+//if destroyed object holds other last SharedPtr, they go to the same queue, so big trees are freed step by step
+//queue is thread-local and must be drained by the thread which filled it
+//only the case without WeakPtr is deferred, otherwise WeakPtr must see that object is expired
+
+struct ReleaseQueue {
+	struct Entry {
+		BaseControlBlock* base_control_block;
+		BaseRealAllocator* base_real_allocator;
+	};
+
+	std::deque<Entry> entries;
+
+	static bool& deferred() {
+		//flag is trivially destructible, so it can be read at any time, even after the queue is destroyed
+		//eager release reads only this flag and does not touch the queue
+		thread_local bool flag = false;
+		return flag;
+	}
+
+	static bool& finished() {
+		//queue of this thread is destroyed, all releases are eager now
+		thread_local bool flag = false;
+		return flag;
+	}
+
+	static ReleaseQueue& instance() {
+		//must not be called if finished()
+		thread_local ReleaseQueue queue;
+		return queue;
+	}
+
+	void push(BaseControlBlock* base_control_block, BaseRealAllocator* base_real_allocator) {
+		entries.push_back(Entry{base_control_block, base_real_allocator});
+	}
+
+	size_t drain(size_t budget) {
+		//return number of destroyed objects
+		size_t destroyed = 0;
+		while (destroyed < budget && !entries.empty()) {
+			Entry entry = entries.front();
+			entries.pop_front();
+			//destructor of object can push new entries
+			entry.base_control_block->~BaseControlBlock();
+			entry.base_real_allocator->free_memory(entry.base_real_allocator);
+			++destroyed;
+		}
+		return destroyed;
+	}
+
+	~ReleaseQueue() {
+		//thread is finished, all other releases are eager
+		deferred() = false;
+		while (!entries.empty()) {
+			drain(entries.size());
+		}
+		finished() = true;
+	}
+};
+
+inline void setDeferredRelease(bool flag) {
+	if (ReleaseQueue::finished()) {
+		return;
+	}
+	if (flag) {
+		ReleaseQueue::instance();
+		//queue is made before the first deferred release, so it is destroyed at end of thread
+	}
+	ReleaseQueue::deferred() = flag;
+}
+
+inline size_t drainReleaseQueue(size_t budget) {
+	if (ReleaseQueue::finished()) {
+		return 0;
+	}
+	return ReleaseQueue::instance().drain(budget);
+}
+
+inline size_t pendingReleaseCount() {
+	if (ReleaseQueue::finished()) {
+		return 0;
+	}
+	return ReleaseQueue::instance().entries.size();
+}
+
 //Simple help function
 template <typename Y>
 void help_swap(Y* y1, Y* y2) {
@@ -249,6 +639,9 @@ class SharedPtr;
 template <typename T>
 class WeakPtr;
 
+template <typename T>
+class EnableSharedFromThis;
+
 template <typename T>
 class SharedPtr {
 
@@ -259,6 +652,9 @@ private:
 	template <typename U>
 	friend class WeakPtr;
 
+	template <typename U>
+	friend class AtomicSharedPtr;
+
 	template <typename U, class... Args>
 	friend SharedPtr<U> makeShared(Args&&...);
 
@@ -288,8 +684,8 @@ private:
 		ControlBlock<Deleter, RealT>* control_block_tmp = reinterpret_cast<ControlBlock<Deleter, RealT>*>(
 				all_array + sizeof(RealAllocator<Allocator>) + sizeof(Count));
 
-		count_tmp->shared_ptr_count = 1;
-		count_tmp->weak_ptr_count = 0;
+		new(count_tmp) Count(1, 0);
+		SharedPtrInstrumentation<T>::on_construct(count_tmp, false);
 
 		new(control_block_tmp) ControlBlock<Deleter, RealT>(object, object_deleter);
 
@@ -299,6 +695,9 @@ private:
 		count = count_tmp;
 		base_control_block = static_cast<BaseControlBlock*>(control_block_tmp);
 		base_real_allocator = static_cast<BaseRealAllocator*>(real_allocator_tmp);
+
+		enable_shared_from_this(object, object);
+		//object, not pointer_quick_work: SharedPtr<Base> can own heir which is EnableSharedFromThis
 	}
 	
 	template <class Allocator, class Deleter>
@@ -322,8 +721,8 @@ private:
 		T* object = reinterpret_cast<T*>(all_array + sizeof(RealAllocator<Allocator>) + sizeof(Count) + sizeof(ControlBlock<Deleter, T>));
 		//in this function we think that object is real object of type T
 
-		count_tmp->shared_ptr_count = 1;
-		count_tmp->weak_ptr_count = 0;
+		new(count_tmp) Count(1, 0);
+		SharedPtrInstrumentation<T>::on_construct(count_tmp, true);
 
 		new(control_block_tmp) ControlBlock<Deleter, T>(object, object_deleter);
 
@@ -339,10 +738,14 @@ private:
 		//real destructor of all object
 		//called if this is last shared ptr
 
-		base_control_block->~BaseControlBlock();
+		if (ReleaseQueue::deferred()) {
+			ReleaseQueue::instance().push(base_control_block, base_real_allocator);
+		} else {
+			base_control_block->~BaseControlBlock();
 
-		base_real_allocator->free_memory(base_real_allocator);
-		//it is destructor for this object with memory for pointer
+			base_real_allocator->free_memory(base_real_allocator);
+			//it is destructor for this object with memory for pointer
+		}
 
 		pointer_quick_work = nullptr;
 		count = nullptr;
@@ -350,6 +753,24 @@ private:
 		base_real_allocator = nullptr;
 	}
 
+	template <typename U, typename RealT>
+	void enable_shared_from_this(const EnableSharedFromThis<U>* base, RealT* object) {
+		//called when object is constructed and owned by this shared ptr
+		//object which is owned already keeps its old owner
+		//weak_this points to object as U, it is made without SharedPtr<U>, so it is not counted as copy
+		if (base != nullptr && base->weak_this.use_count() == 0) {
+			WeakPtr<U> weak_this;
+			weak_this.pointer_quick_work = const_cast<U*>(static_cast<const U*>(object));
+			weak_this.count = count;
+			weak_this.base_control_block = base_control_block;
+			weak_this.base_real_allocator = base_real_allocator;
+			++count->weak_ptr_count;
+			base->weak_this = std::move(weak_this);
+		}
+	}
+
+	void enable_shared_from_this(...) {}
+
 	//four pointers and three methods of construct and destroy contains all internal logic of shared ptr
 	//other functions will be work with them
 	
@@ -370,7 +791,8 @@ public:
 	explicit SharedPtr(Y* ptr) {
 		std::allocator<T> alloc;
 		AllocatorDeleter<std::allocator<T>> del(alloc);
-		construct_shared_ptr_with_ready_pointer(ptr, del, alloc);
+		ControlBlockPoolAllocator<T> pool_alloc;
+		construct_shared_ptr_with_ready_pointer(ptr, del, pool_alloc);
 	}
 
 private:
@@ -405,13 +827,20 @@ private:
 	void destroy_this_shared_ptr() {
 		if (count != nullptr) {
 			assert(count->shared_ptr_count > 0);
-			--count->shared_ptr_count;
-			if (count->shared_ptr_count == 0 &&
+			size_t shared_ptr_count_left = --count->shared_ptr_count;
+			if (shared_ptr_count_left == 0) {
+				SharedPtrInstrumentation<T>::on_object_destroyed(count);
+			}
+			if (shared_ptr_count_left == 0 &&
 					count->weak_ptr_count != 0) {
+				//object can hold WeakPtr to itself (EnableSharedFromThis)
+				//control block must live while object is destroyed
+				++count->weak_ptr_count;
 				base_control_block->delete_object_but_not_control_block();
-			}
-			if (count->shared_ptr_count == 0 &&
-					count->weak_ptr_count == 0) {
+				if (--count->weak_ptr_count == 0) {
+					destructor();
+				}
+			} else if (shared_ptr_count_left == 0) {
 				destructor();
 			}
 		}
@@ -421,15 +850,17 @@ public:
 	template <typename Y>
 	SharedPtr(const SharedPtr<Y>& y) {
 		copy_all_pointers_from_other_shared_ptr(std::move(y));
-		if (pointer_quick_work != nullptr) {
+		if (count != nullptr) {
 			++count->shared_ptr_count;
+			SharedPtrInstrumentation<T>::on_copy();
 		}
 	}
 	
 	SharedPtr(const SharedPtr& y) {
 		copy_all_pointers_from_other_shared_ptr(std::move(y));
-		if (pointer_quick_work != nullptr) {
+		if (count != nullptr) {
 			++count->shared_ptr_count;
+			SharedPtrInstrumentation<T>::on_copy();
 		}
 	}
 
@@ -437,19 +868,40 @@ public:
 	SharedPtr(SharedPtr<Y>&& y) {
 		copy_all_pointers_from_other_shared_ptr(std::move(y));
 		make_nullptr_all_pointers_from_other_shared_ptr(std::move(y));
+		if (count != nullptr) {
+			SharedPtrInstrumentation<T>::on_move();
+		}
 	}
 	
 	SharedPtr(SharedPtr&& y) {
 		copy_all_pointers_from_other_shared_ptr(std::move(y));
 		make_nullptr_all_pointers_from_other_shared_ptr(std::move(y));
+		if (count != nullptr) {
+			SharedPtrInstrumentation<T>::on_move();
+		}
+	}
+
+	template <typename Y>
+	SharedPtr(const SharedPtr<Y>& owner, T* member) {
+		//aliasing constructor: share ownership of owner, but point to member
+		//no allocation, only counter is changed
+		pointer_quick_work = member;
+		count = owner.count;
+		base_control_block = owner.base_control_block;
+		base_real_allocator = owner.base_real_allocator;
+		if (count != nullptr) {
+			++count->shared_ptr_count;
+			SharedPtrInstrumentation<T>::on_copy();
+		}
 	}
 
 	template <typename Y>
 	SharedPtr& operator=(const SharedPtr<Y>& y) {
 		destroy_this_shared_ptr();
 		copy_all_pointers_from_other_shared_ptr(std::move(y));
-		if (pointer_quick_work != nullptr) {
+		if (count != nullptr) {
 			++count->shared_ptr_count;
+			SharedPtrInstrumentation<T>::on_copy();
 		}
 		return *this;
 	}
@@ -457,8 +909,9 @@ public:
 	SharedPtr& operator=(const SharedPtr& y) {
 		destroy_this_shared_ptr();
 		copy_all_pointers_from_other_shared_ptr(std::move(y));
-		if (pointer_quick_work != nullptr) {
+		if (count != nullptr) {
 			++count->shared_ptr_count;
+			SharedPtrInstrumentation<T>::on_copy();
 		}
 		return *this;
 	}
@@ -468,6 +921,9 @@ public:
 		destroy_this_shared_ptr();
 		copy_all_pointers_from_other_shared_ptr(std::move(y));
 		make_nullptr_all_pointers_from_other_shared_ptr(std::move(y));
+		if (count != nullptr) {
+			SharedPtrInstrumentation<T>::on_move();
+		}
 		return *this;
 	}
 	
@@ -475,6 +931,9 @@ public:
 		destroy_this_shared_ptr();
 		copy_all_pointers_from_other_shared_ptr(std::move(y));
 		make_nullptr_all_pointers_from_other_shared_ptr(std::move(y));
+		if (count != nullptr) {
+			SharedPtrInstrumentation<T>::on_move();
+		}
 		return *this;
 	}
 
@@ -484,7 +943,7 @@ public:
 
 public:
 	size_t use_count() const {
-		if (pointer_quick_work != nullptr) {
+		if (count != nullptr) {
 			return count->shared_ptr_count;
 		}
 		return 1;
@@ -502,7 +961,8 @@ public:
 
 		std::allocator<T> alloc;
 		AllocatorDeleter<std::allocator<T>> del(alloc);
-		construct_shared_ptr_with_ready_pointer(ptr, del, alloc);
+		ControlBlockPoolAllocator<T> pool_alloc;
+		construct_shared_ptr_with_ready_pointer(ptr, del, pool_alloc);
 	}
 	
 	void swap(SharedPtr& smart_pointer) {
@@ -527,8 +987,8 @@ public:
 public:
 	template <typename Y, class Deleter>
 	SharedPtr(Y* ptr, const Deleter& del) {
-		std::allocator<T> alloc;
-		construct_shared_ptr_with_ready_pointer(ptr, del, alloc);
+		ControlBlockPoolAllocator<T> pool_alloc;
+		construct_shared_ptr_with_ready_pointer(ptr, del, pool_alloc);
 	}
 
 	template <typename Y, class Deleter, class Allocator>
@@ -553,6 +1013,7 @@ SharedPtr<T> makeShared(Args&&... args) {
 		smart_ptr.base_control_block->change_condition_of_destroy_object(false);
 		throw;
 	}
+	smart_ptr.enable_shared_from_this(smart_ptr.pointer_quick_work, smart_ptr.pointer_quick_work);
 
 	return smart_ptr;
 }
@@ -572,6 +1033,7 @@ SharedPtr<T> allocateShared(Allocator& alloc, Args&&... args) {
 		smart_ptr.base_control_block->change_condition_of_destroy_object(false);
 		throw;
 	}
+	smart_ptr.enable_shared_from_this(smart_ptr.pointer_quick_work, smart_ptr.pointer_quick_work);
 
 	return smart_ptr;
 }
@@ -583,6 +1045,9 @@ private:
 	template <typename U>
 	friend class WeakPtr;
 
+	template <typename U>
+	friend class SharedPtr;
+
 private:
 	T* pointer_quick_work;
 	Count* count;
@@ -599,20 +1064,13 @@ public:
 
 	template <typename U>
 	WeakPtr(const SharedPtr<U>& smart_ptr_u) {
-		SharedPtr<T> smart_ptr_t(smart_ptr_u);
-		
-		pointer_quick_work = smart_ptr_t.pointer_quick_work;
-		count = smart_ptr_t.count;
-		base_control_block = smart_ptr_t.base_control_block;
-		base_real_allocator = smart_ptr_t.base_real_allocator;
-		
-		smart_ptr_t.pointer_quick_work = nullptr;
-		smart_ptr_t.count = nullptr;
-		smart_ptr_t.base_control_block = nullptr;
-		smart_ptr_t.base_real_allocator = nullptr;
+		//pointers are taken directly, temporary SharedPtr<T> would be counted as copy
+		pointer_quick_work = static_cast<T*>(smart_ptr_u.pointer_quick_work);
+		count = smart_ptr_u.count;
+		base_control_block = smart_ptr_u.base_control_block;
+		base_real_allocator = smart_ptr_u.base_real_allocator;
 
-		if (pointer_quick_work != nullptr) {
-			--count->shared_ptr_count;
+		if (count != nullptr) {
 			++count->weak_ptr_count;
 		}
 	}
@@ -652,9 +1110,9 @@ private:
 	void destroy_this_weak_ptr() {
 		if (count != nullptr) {
 			assert(count->weak_ptr_count > 0);
-			--count->weak_ptr_count;
+			size_t weak_ptr_count_left = --count->weak_ptr_count;
 			if (count->shared_ptr_count == 0 &&
-					count->weak_ptr_count == 0) {
+					weak_ptr_count_left == 0) {
 				destructor();
 			}
 		}
@@ -664,14 +1122,14 @@ public:
 	template <typename Y>
 	WeakPtr(const WeakPtr<Y>& y) {
 		copy_all_pointers_from_other_weak_ptr(std::move(y));
-		if (pointer_quick_work != nullptr) {
+		if (count != nullptr) {
 			++count->weak_ptr_count;
 		}
 	}
 	
 	WeakPtr(const WeakPtr& y) {
 		copy_all_pointers_from_other_weak_ptr(std::move(y));
-		if (pointer_quick_work != nullptr) {
+		if (count != nullptr) {
 			++count->weak_ptr_count;
 		}
 	}
@@ -691,7 +1149,7 @@ public:
 	WeakPtr& operator=(const WeakPtr<Y>& y) {
 		destroy_this_weak_ptr();
 		copy_all_pointers_from_other_weak_ptr(std::move(y));
-		if (pointer_quick_work != nullptr) {
+		if (count != nullptr) {
 			++count->weak_ptr_count;
 		}
 		return *this;
@@ -700,7 +1158,7 @@ public:
 	WeakPtr& operator=(const WeakPtr& y) {
 		destroy_this_weak_ptr();
 		copy_all_pointers_from_other_weak_ptr(std::move(y));
-		if (pointer_quick_work != nullptr) {
+		if (count != nullptr) {
 			++count->weak_ptr_count;
 		}
 		return *this;
@@ -726,7 +1184,7 @@ public:
 	}
 	
 	size_t use_count() const {
-		if (pointer_quick_work != nullptr) {
+		if (count != nullptr) {
 			return count->shared_ptr_count;
 		}
 		return 0;
@@ -737,14 +1195,236 @@ public:
 	}
 
 	SharedPtr<T> lock() const {
+		//empty SharedPtr if object is already destroyed
 		SharedPtr<T> smart_ptr(0);
+		if (count == nullptr) {
+			return smart_ptr;
+		}
+		size_t shared_ptr_count_tmp = count->shared_ptr_count;
+		do {
+			if (shared_ptr_count_tmp == 0) {
+				SharedPtrInstrumentation<T>::on_failed_weak_lock();
+				return smart_ptr;
+			}
+		} while (!count->shared_ptr_count.compare_exchange_weak(shared_ptr_count_tmp, shared_ptr_count_tmp + 1));
+
 		smart_ptr.pointer_quick_work = pointer_quick_work;
 		smart_ptr.count = count;
 		smart_ptr.base_control_block = base_control_block;
 		smart_ptr.base_real_allocator = base_real_allocator;
-
-		++smart_ptr.count->shared_ptr_count;
 		return smart_ptr;
 	}
 
 };
+
+//Class EnableSharedFromThis
+
+//T is inherited from EnableSharedFromThis<T>
+//SharedPtr which becomes first owner of object puts WeakPtr to itself in weak_this
+//shared_from_this makes new SharedPtr with the same control block, without allocation
+
+template <typename T>
+class EnableSharedFromThis {
+
+private:
+	template <typename U>
+	friend class SharedPtr;
+
+	mutable WeakPtr<T> weak_this;
+
+protected:
+	EnableSharedFromThis() {}
+
+	EnableSharedFromThis(const EnableSharedFromThis&) {}
+	//copy of object has other owner
+
+	EnableSharedFromThis& operator=(const EnableSharedFromThis&) {
+		return *this;
+	}
+
+	~EnableSharedFromThis() = default;
+
+public:
+	SharedPtr<T> shared_from_this() {
+		if (weak_this.use_count() == 0) {
+			throw std::bad_weak_ptr();
+		}
+		return weak_this.lock();
+	}
+
+	SharedPtr<const T> shared_from_this() const {
+		if (weak_this.use_count() == 0) {
+			throw std::bad_weak_ptr();
+		}
+		return weak_this.lock();
+	}
+
+	WeakPtr<T> weak_from_this() const {
+		return weak_this;
+	}
+
+};
+
+//Class AtomicSharedPtr
+
+//Main idea (split reference counts):
+//AtomicSharedPtr keeps one 64-bit word: pointer to StoredSharedPtr in low 48 bits and local count in high 16 bits
+//StoredSharedPtr is a heap copy of published SharedPtr, so all four pointers are changed by one atomic operation
+//reader increments local count in the word, copies SharedPtr and then decrements local count back
+//if word was replaced while reader copied, reader decrements internal_count of StoredSharedPtr instead
+//writer, which replaced word, adds old local count to internal_count
+//StoredSharedPtr is deleted by the one who makes internal_count zero
+//readers never wait for writers and never take a lock
+
+template <typename T>
+class AtomicSharedPtr {
+
+private:
+	struct StoredSharedPtr {
+		SharedPtr<T> value;
+		std::atomic<long long> internal_count;
+
+		StoredSharedPtr(const SharedPtr<T>& value_tmp) : value(value_tmp), internal_count(0) {}
+	};
+
+	static_assert(sizeof(void*) == 8, "AtomicSharedPtr packs pointer in 48 bits of 64-bit word");
+
+	static constexpr uint64_t kLocalCountShift = 48;
+	static constexpr uint64_t kOneLocalCount = uint64_t(1) << kLocalCountShift;
+	static constexpr uint64_t kPointerMask = kOneLocalCount - 1;
+
+	mutable std::atomic<uint64_t> word;
+	//readers change local count, so word is mutable
+
+	static uint64_t pack(StoredSharedPtr* stored) {
+		uint64_t value = reinterpret_cast<uint64_t>(stored);
+		assert((value & ~kPointerMask) == 0);
+		//high 16 bits are for local count, pointer must fit in 48 bits
+		return value;
+	}
+
+	static StoredSharedPtr* stored_pointer(uint64_t value) {
+		return reinterpret_cast<StoredSharedPtr*>(value & kPointerMask);
+	}
+
+	static long long local_count(uint64_t value) {
+		return static_cast<long long>(value >> kLocalCountShift);
+	}
+
+	static StoredSharedPtr* make_stored(const SharedPtr<T>& smart_ptr) {
+		//empty SharedPtr is stored as nullptr
+		if (smart_ptr.count == nullptr) {
+			return nullptr;
+		}
+		return new StoredSharedPtr(smart_ptr);
+	}
+
+	static void add_internal_count(StoredSharedPtr* stored, long long value) {
+		if (stored != nullptr && (stored->internal_count += value) == 0) {
+			delete stored;
+		}
+	}
+
+	StoredSharedPtr* acquire_local() const {
+		//after this stored object can not be deleted until release_local
+		uint64_t current = word.load();
+		while (stored_pointer(current) != nullptr &&
+				!word.compare_exchange_weak(current, current + kOneLocalCount)) {}
+		return stored_pointer(current);
+	}
+
+	void release_local(StoredSharedPtr* stored) const {
+		if (stored == nullptr) {
+			return;
+		}
+		uint64_t current = word.load();
+		while (stored_pointer(current) == stored) {
+			if (word.compare_exchange_weak(current, current - kOneLocalCount)) {
+				return;
+			}
+		}
+		//word was replaced and writer gave our local count to internal_count
+		add_internal_count(stored, -1);
+	}
+
+	static bool same_shared_ptr(StoredSharedPtr* stored, const SharedPtr<T>& smart_ptr) {
+		if (stored == nullptr) {
+			return smart_ptr.count == nullptr;
+		}
+		return stored->value.count == smart_ptr.count &&
+				stored->value.pointer_quick_work == smart_ptr.pointer_quick_work;
+	}
+
+public:
+	AtomicSharedPtr() : word(0) {}
+
+	AtomicSharedPtr(const SharedPtr<T>& smart_ptr) : word(pack(make_stored(smart_ptr))) {}
+
+	AtomicSharedPtr(const AtomicSharedPtr&) = delete;
+
+	AtomicSharedPtr& operator=(const AtomicSharedPtr&) = delete;
+
+	~AtomicSharedPtr() {
+		uint64_t current = word.load();
+		add_internal_count(stored_pointer(current), local_count(current));
+	}
+
+	SharedPtr<T> load() const {
+		StoredSharedPtr* stored = acquire_local();
+		SharedPtr<T> answer;
+		if (stored != nullptr) {
+			answer = stored->value;
+		}
+		release_local(stored);
+		return answer;
+	}
+
+	SharedPtr<T> exchange(const SharedPtr<T>& smart_ptr) {
+		StoredSharedPtr* new_stored = make_stored(smart_ptr);
+		uint64_t old = word.exchange(pack(new_stored));
+		StoredSharedPtr* old_stored = stored_pointer(old);
+
+		SharedPtr<T> answer;
+		if (old_stored != nullptr) {
+			answer = old_stored->value;
+		}
+		add_internal_count(old_stored, local_count(old));
+		return answer;
+	}
+
+	void store(const SharedPtr<T>& smart_ptr) {
+		exchange(smart_ptr);
+	}
+
+	bool compare_exchange(SharedPtr<T>& expected, const SharedPtr<T>& desired) {
+		//compare by owned object, as std::atomic<std::shared_ptr>
+		//if not equal, expected becomes current value
+		StoredSharedPtr* new_stored = make_stored(desired);
+		while (true) {
+			StoredSharedPtr* stored = acquire_local();
+			if (!same_shared_ptr(stored, expected)) {
+				expected = (stored != nullptr) ? stored->value : SharedPtr<T>();
+				release_local(stored);
+				delete new_stored;
+				return false;
+			}
+
+			uint64_t current = word.load();
+			while (stored_pointer(current) == stored) {
+				if (word.compare_exchange_weak(current, pack(new_stored))) {
+					//our own local count is in current too
+					if (stored != nullptr) {
+						add_internal_count(stored, local_count(current) - 1);
+					}
+					return true;
+				}
+			}
+			release_local(stored);
+		}
+	}
+
+	bool is_lock_free() const {
+		return word.is_lock_free();
+	}
+
+};
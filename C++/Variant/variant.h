@@ -1,51 +1,129 @@
-#pragma GCC optimize("O0")
+#pragma once
+//Variant needs C++20: special member functions are trivial only if all types have trivial ones
+//and Variant of literal types is usable in constant expressions
 
 #include <initializer_list>
 #include <type_traits>
+#include <utility>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <exception>
 
 #include <iostream>
 #include <cassert>
 
+static constexpr size_t variant_npos = std::numeric_limits<size_t>::max();
+
+template <typename T, typename... Types>
+struct VariantIndexOf {
+	//index of the first T in Types, found at compile time without any object
+	static constexpr size_t value = [] {
+		constexpr bool is_same[] = {std::is_same_v<T, Types>..., false};
+		for (size_t i = 0; i < sizeof...(Types); ++i) {
+			if (is_same[i]) {
+				return i;
+			}
+		}
+		return variant_npos;
+	}();
+	static_assert(value != variant_npos, "Variant does not have this type");
+};
+
+template <typename T, typename... Types>
+static constexpr size_t variant_index_of_v = VariantIndexOf<T, Types...>::value;
+
+template <size_t I, typename T>
+struct VariantOverload {
+	//imaginary function F(T) for alternative I
+	//it is in overload set only if T x[] = {value} compiles, so narrowing conversions are not used
+	template <typename U>
+	requires requires (U&& value) { std::type_identity_t<T[]>{std::forward<U>(value)}; }
+	std::integral_constant<size_t, I> operator()(T, U&&) const;
+};
+
+template <typename Indices, typename... Types>
+struct VariantOverloadSet;
+
+template <size_t... Is, typename... Types>
+struct VariantOverloadSet<std::index_sequence<Is...>, Types...> : VariantOverload<Is, Types>... {
+	using VariantOverload<Is, Types>::operator()...;
+};
+
+template <typename U, typename... Types>
+using VariantConvertingIndex = decltype(
+	VariantOverloadSet<std::index_sequence_for<Types...>, Types...>{}(std::declval<U>(), std::declval<U>())
+);
+//alternative chosen by overload resolution among F(Types)..., as for std::variant
+//ill-formed if there is no best alternative
+
+template <typename U, typename... Types>
+concept VariantConvertible = requires { VariantConvertingIndex<U, Types...>::value; };
+
+class BadVariantAccess : public std::exception {
+public:
+	explicit BadVariantAccess(const char* message) : message(message) {}
+
+	const char* what() const noexcept override {
+		return message;
+	}
+
+private:
+	const char* message;
+};
+
+[[noreturn]] inline void throw_bad_variant_access(const char* message) {
+	//throw is out of get, so get is small and can be inlined
+	throw BadVariantAccess(message);
+}
+
+template <typename... Types>
+struct VariantOperations;
+
+template <typename... Types>
+struct VariantStorage;
+
 template <typename Head, typename... Tail>
 union VariantUnion {
 	Head head;
 	VariantUnion<Tail...> tail;
 	
-	VariantUnion() {}
-	~VariantUnion() {}
+	constexpr VariantUnion() {}
+	~VariantUnion() requires (std::is_trivially_destructible_v<Head> && ... && std::is_trivially_destructible_v<Tail>) = default;
+	constexpr ~VariantUnion() {}
 	
-	template <typename T, size_t N = 0>
-	constexpr size_t get_index_by_type() {
-		//find type T in VariantUnion and return its index
-		//static_assert if VariantUnion does not have T type
-		if constexpr (std::is_same_v<T, Head>) {
-			return N;
+	template <size_t N, class... Args>
+	constexpr void construct(Args&&... args) {
+		//construct element of type with index N
+		//if constructor throws, exception goes to caller
+		if constexpr (N == 0) {
+			using NonConstHead = typename std::remove_const_t<Head>;
+			NonConstHead* non_const_pointer = const_cast<NonConstHead*>(&head);
+			std::construct_at(non_const_pointer, std::forward<Args>(args)...);
 		} else {
-			return tail.template get_index_by_type<T, N+1>();
+			//tail becomes active member of union, it is not allowed to touch inactive member in constexpr
+			std::construct_at(&tail);
+			tail.template construct<N-1>(std::forward<Args>(args)...);
 		}
 	}
 	
 	template <size_t N, class... Args>
-	bool push(Args&&... args) {
+	constexpr bool push(Args&&... args) {
 		//construct element of type with index N
 		//true if all is OK
 		//false else
-		if constexpr (N == 0) {
-			try {
-				using NonConstHead = typename std::remove_const_t<Head>;
-				NonConstHead* non_const_pointer = const_cast<NonConstHead*>(&head);
-				new(non_const_pointer) Head(std::forward<Args>(args)...);
-			} catch(...) {
-				return false;
-			}
-			return true;
-		} else {
-			return tail.template push<N-1, Args...>(args...);
+		try {
+			construct<N>(std::forward<Args>(args)...);
+		} catch(...) {
+			return false;
 		}
+		return true;
 	}
 	
 	template <size_t N>
-	auto& get() {
+	constexpr auto& get() {
 		//get element by index from union
 		if constexpr (N == 0) {
 			return head;
@@ -55,7 +133,7 @@ union VariantUnion {
 	}
 	
 	template <size_t N>
-	const auto& get() const {
+	constexpr const auto& get() const {
 		//get element by index from union
 		if constexpr (N == 0) {
 			return head;
@@ -64,13 +142,9 @@ union VariantUnion {
 		}
 	}
 	
-	void destroy(size_t N) {
+	constexpr void destroy(size_t N) {
 		//delete element by index from union
-		if (N == 0) {
-			head.~Head();
-		} else {
-			tail.destroy(N-1);
-		}
+		VariantOperations<Head, Tail...>::destroy(*this, N);
 	}
 };
 
@@ -78,27 +152,27 @@ template <typename Head>
 union VariantUnion<Head> {
 	Head head;
 	
-	VariantUnion() {}
-	~VariantUnion() {}
+	constexpr VariantUnion() {}
+	~VariantUnion() requires std::is_trivially_destructible_v<Head> = default;
+	constexpr ~VariantUnion() {}
 	
-	template <typename T, size_t N = 0>
-	constexpr size_t get_index_by_type() {
-		//find type T in VariantUnion and return its index
-		//static_assert if VariantUnion does not have T type
-		static_assert(std::is_same_v<T, Head>);
-		return N;
+	template <size_t N, class... Args>
+	constexpr void construct(Args&&... args) {
+		//construct element of type with index N
+		//if constructor throws, exception goes to caller
+		static_assert(N == 0, "Union contains less number of elements");
+		using NonConstHead = typename std::remove_const_t<Head>;
+		NonConstHead* non_const_pointer = const_cast<NonConstHead*>(&head);
+		std::construct_at(non_const_pointer, std::forward<Args>(args)...);
 	}
 	
 	template <size_t N, class... Args>
-	bool push(Args&&... args) {
+	constexpr bool push(Args&&... args) {
 		//construct element of type with index N
 		//true if all is OK
 		//false else
-		static_assert(N == 0, "Union contains less number of elements");
 		try {
-			using NonConstHead = typename std::remove_const_t<Head>;
-			NonConstHead* non_const_pointer = const_cast<NonConstHead*>(&head);
-			new(non_const_pointer) Head(std::forward<Args>(args)...);
+			construct<N>(std::forward<Args>(args)...);
 		} catch(...) {
 			return false;
 		}
@@ -106,66 +180,245 @@ union VariantUnion<Head> {
 	}
 	
 	template <size_t N>
-	auto& get() {
+	constexpr auto& get() {
 		//get element by index from union
 		static_assert(N == 0, "Union contains less number of elements");
 		return head;
 	}
 	
 	template <size_t N>
-	const auto& get() const {
+	constexpr const auto& get() const {
 		//get element by index from union
 		static_assert(N == 0, "Union contains less number of elements");
 		return head;
 	}
 
-	void destroy(size_t N) {
+	constexpr void destroy(size_t N) {
 		//delete element by index from union
 		assert(N == 0);
-		head.~Head();
+		VariantOperations<Head>::destroy(*this, N);
+	}
+};
+
+template <typename... Types>
+struct VariantOperations {
+	//operations with element of VariantUnion by runtime index
+	//each operation has compile-time table of functions for all indices
+	//so operation is one indexed jump, not recursion through the union
+
+	using Union = VariantUnion<Types...>;
+	using Storage = VariantStorage<Types...>;
+
+	template <size_t I>
+	struct Destroy {
+		static constexpr void apply(Union& to) {
+			std::destroy_at(&to.template get<I>());
+		}
+	};
+
+	template <size_t I>
+	struct CopyConstruct {
+		static constexpr void apply(Storage& to, const Union& from) {
+			to.template emplace_to_empty<I>(from.template get<I>());
+		}
+	};
+
+	template <size_t I>
+	struct MoveConstruct {
+		static constexpr void apply(Storage& to, Union& from) {
+			to.template emplace_to_empty<I>(std::move(from.template get<I>()));
+		}
+	};
+
+	template <size_t I>
+	struct CopyReplace {
+		static constexpr void apply(Storage& to, const Union& from) {
+			to.template replace<I>(from.template get<I>());
+		}
+	};
+
+	template <size_t I>
+	struct MoveReplace {
+		static constexpr void apply(Storage& to, Union& from) {
+			to.template replace<I>(std::move(from.template get<I>()));
+		}
+	};
+
+	template <size_t I>
+	struct CopyAssign {
+		static constexpr void apply(Union& to, const Union& from) {
+			to.template get<I>() = from.template get<I>();
+		}
+	};
+
+	template <size_t I>
+	struct MoveAssign {
+		static constexpr void apply(Union& to, Union& from) {
+			to.template get<I>() = std::move(from.template get<I>());
+		}
+	};
+
+	template <size_t I>
+	struct Swap {
+		static constexpr void apply(Union& left, Union& right) {
+			using std::swap;
+			swap(left.template get<I>(), right.template get<I>());
+		}
+	};
+
+	template <template <size_t> class Operation, size_t... Is>
+	static constexpr auto make_table(std::index_sequence<Is...>) {
+		return std::array{&Operation<Is>::apply...};
+	}
+
+	template <template <size_t> class Operation>
+	static constexpr auto table = make_table<Operation>(std::index_sequence_for<Types...>());
+
+	static constexpr void destroy(Union& to, size_t index) {
+		table<Destroy>[index](to);
+	}
+
+	static constexpr void copy_construct(Storage& to, const Union& from, size_t index) {
+		table<CopyConstruct>[index](to, from);
+	}
+
+	static constexpr void move_construct(Storage& to, Union& from, size_t index) {
+		table<MoveConstruct>[index](to, from);
+	}
+
+	static constexpr void copy_replace(Storage& to, const Union& from, size_t index) {
+		table<CopyReplace>[index](to, from);
+	}
+
+	static constexpr void move_replace(Storage& to, Union& from, size_t index) {
+		table<MoveReplace>[index](to, from);
+	}
+
+	static constexpr void copy_assign(Union& to, const Union& from, size_t index) {
+		table<CopyAssign>[index](to, from);
+	}
+
+	static constexpr void move_assign(Union& to, Union& from, size_t index) {
+		table<MoveAssign>[index](to, from);
+	}
+
+	static constexpr void swap(Union& left, Union& right, size_t index) {
+		table<Swap>[index](left, right);
 	}
 };
 
 template <typename... Types>
 class Variant;
 
+template <size_t N>
+using VariantIndexType = std::conditional_t<(N < std::numeric_limits<uint8_t>::max()), uint8_t,
+	std::conditional_t<(N < std::numeric_limits<uint16_t>::max()), uint16_t, uint32_t>>;
+//the smallest type for indices of N types and one more value for empty variant
+
+template <typename... Types>
+struct VariantPolicy {
+	//specialize with never_valueless = true to make Variant<Types...> never valueless:
+	//constructors of Variant throw instead of making empty variant
+	//new element is constructed in temporary and moved in, if its constructor can throw
+	//if move of some type can throw too, Variant has second buffer for new element
+	//old element lives until new one is ready, so variant always has element
+	static constexpr bool never_valueless = false;
+};
+
+template <typename... Types>
+struct VariantStorage {
+	//state of Variant is in the first base class
+	//so it is alive before constructors of VariantParent write in it
+
+	using IndexType = VariantIndexType<sizeof...(Types)>;
+	static constexpr IndexType kValueless = std::numeric_limits<IndexType>::max();
+
+	static constexpr bool never_valueless = VariantPolicy<Types...>::never_valueless;
+	static constexpr bool double_buffered = never_valueless && !(std::is_nothrow_move_constructible_v<Types> && ...);
+
+	VariantUnion<Types...> buffers[double_buffered ? 2 : 1];
+	[[no_unique_address]] std::conditional_t<double_buffered, bool, std::false_type> active_buffer{};
+	IndexType used_index = kValueless;
+	//index of used type, kValueless if element does not exist
+	//Variant<int, double> takes 16 bytes, not 24 as with size_t index and bool flag
+
+	constexpr VariantUnion<Types...>& storage() {
+		return buffers[static_cast<bool>(active_buffer)];
+	}
+
+	constexpr const VariantUnion<Types...>& storage() const {
+		return buffers[static_cast<bool>(active_buffer)];
+	}
+
+	constexpr bool non_empty() const {
+		if constexpr (never_valueless) {
+			return true;
+		}
+		return used_index != kValueless;
+	}
+
+	constexpr void set_used_index(size_t index, bool is_pushed) {
+		//push returns false if constructor throws, then variant is empty
+		used_index = is_pushed ? static_cast<IndexType>(index) : kValueless;
+	}
+
+	template <size_t I, typename... Args>
+	constexpr void emplace_to_empty(Args&&... args) {
+		//variant does not have element now
+		if constexpr (never_valueless) {
+			storage().template construct<I>(std::forward<Args>(args)...);
+			used_index = I;
+		} else {
+			set_used_index(I, storage().template push<I>(std::forward<Args>(args)...));
+		}
+	}
+
+	template <size_t I, typename... Args>
+	constexpr void replace(Args&&... args) {
+		//destroy old element if it exists and construct element with index I
+		using Element = std::remove_reference_t<decltype(storage().template get<I>())>;
+		if constexpr (!never_valueless || std::is_nothrow_constructible_v<Element, Args...>) {
+			if (used_index != kValueless) {
+				storage().destroy(used_index);
+			}
+			set_used_index(I, storage().template push<I>(std::forward<Args>(args)...));
+		} else if constexpr (std::is_nothrow_move_constructible_v<Element>) {
+			std::remove_const_t<Element> tmp(std::forward<Args>(args)...);
+			//if throw, old element is alive
+			storage().destroy(used_index);
+			storage().template construct<I>(std::move(tmp));
+			used_index = I;
+		} else {
+			VariantUnion<Types...>& spare = buffers[!static_cast<bool>(active_buffer)];
+			spare.template construct<I>(std::forward<Args>(args)...);
+			//if throw, old element is alive
+			storage().destroy(used_index);
+			active_buffer = !active_buffer;
+			used_index = I;
+		}
+	}
+};
+
 template <typename T, typename... Types>
 class VariantParent {
 
 public:
 	using VariantHeir = Variant<Types...>;
+	static constexpr size_t index_of_type_of_variant_parent = variant_index_of_v<T, Types...>;
 	
-	VariantParent() {}
-	
-	VariantParent(const VariantParent&) {}
+	constexpr VariantParent() {}
 	
-	VariantParent(const T& value) {
-		VariantHeir* ptr = static_cast<VariantHeir*>(this);
-		VariantUnion<Types...> union_tmp;
-		static constexpr size_t index_of_type_of_variant_parent = union_tmp.template get_index_by_type<T>();
-		ptr->used_index = index_of_type_of_variant_parent;
-		ptr->non_empty = ptr->storage.template push<index_of_type_of_variant_parent>(value);
-	}
-
-	VariantParent(const T&& value) {
-		VariantHeir* ptr = static_cast<VariantHeir*>(this);
-		VariantUnion<Types...> union_tmp;
-		static constexpr size_t index_of_type_of_variant_parent = union_tmp.template get_index_by_type<T>();
-		ptr->used_index = index_of_type_of_variant_parent;
-		ptr->non_empty = ptr->storage.template push<index_of_type_of_variant_parent>(value);
-	}
+	VariantParent(const VariantParent&) = default;
 	
 	template <typename MakeType>
-	VariantParent(const std::initializer_list<MakeType>& list) {
+	constexpr VariantParent(const std::initializer_list<MakeType>& list) {
 		VariantHeir* ptr = static_cast<VariantHeir*>(this);
-		VariantUnion<Types...> union_tmp;
-		static constexpr size_t index_of_type_of_variant_parent = union_tmp.template get_index_by_type<T>();
-		ptr->used_index = index_of_type_of_variant_parent;
-		ptr->non_empty = ptr->storage.template push<index_of_type_of_variant_parent>(list);
+		ptr->template emplace_to_empty<index_of_type_of_variant_parent>(list);
 	}
 	
 	template <typename... Args, typename = std::enable_if_t<
 		std::conjunction_v<
+			std::bool_constant<(sizeof...(Args) != 1 || (!VariantConvertible<Args, Types...> && ...))>,
 			std::is_constructible<T, Args...>,
 			std::disjunction<
 				std::negation<std::is_constructible<Types, Args...>>,
@@ -173,73 +426,26 @@ public:
 			>...
 		>
 	>>
-	VariantParent(Args&&... args) {
-		VariantHeir* ptr = static_cast<VariantHeir*>(this);
-		VariantUnion<Types...> union_tmp;
-		static constexpr size_t index_of_type_of_variant_parent = union_tmp.template get_index_by_type<T>();
-		ptr->used_index = index_of_type_of_variant_parent;
-		ptr->non_empty = ptr->storage.template push<index_of_type_of_variant_parent>(args...);
-	}
-	
-	VariantHeir& operator=(const T& value) {
+	constexpr VariantParent(Args&&... args) {
 		VariantHeir* ptr = static_cast<VariantHeir*>(this);
-		VariantUnion<Types...> union_tmp;
-		static constexpr size_t index_of_type_of_variant_parent = union_tmp.template get_index_by_type<T>();
-		if (!ptr->non_empty) {
-			ptr->used_index = index_of_type_of_variant_parent;
-			ptr->non_empty = ptr->storage.template push<index_of_type_of_variant_parent>(value);
-			return *ptr;
-		} else if (ptr->used_index == index_of_type_of_variant_parent) {
-			ptr->storage.template get<index_of_type_of_variant_parent>() = value;
-			//if throw all is OK
-			return *ptr;
-		} else {
-			ptr->storage.destroy(ptr->used_index);
-			ptr->used_index = index_of_type_of_variant_parent;
-			ptr->non_empty = ptr->storage.template push<index_of_type_of_variant_parent>(value);
-			return *ptr;
-		}
-	}
-	
-	VariantHeir& operator=(const T&& value) {
-		VariantHeir* ptr = static_cast<VariantHeir*>(this);
-		VariantUnion<Types...> union_tmp;
-		static constexpr size_t index_of_type_of_variant_parent = union_tmp.template get_index_by_type<T>();
-		if (!ptr->non_empty) {
-			ptr->used_index = index_of_type_of_variant_parent;
-			ptr->non_empty = ptr->storage.template push<index_of_type_of_variant_parent>(value);
-			return *ptr;
-		} else if (ptr->used_index == index_of_type_of_variant_parent) {
-			ptr->storage.template get<index_of_type_of_variant_parent>() = value;
-			//if throw all is OK
-			return *ptr;
-		} else {
-			ptr->storage.destroy(ptr->used_index);
-			ptr->used_index = index_of_type_of_variant_parent;
-			ptr->non_empty = ptr->storage.template push<index_of_type_of_variant_parent>(value);
-			return *ptr;
-		}
+		ptr->template emplace_to_empty<index_of_type_of_variant_parent>(std::forward<Args>(args)...);
 	}
 	
 	template <typename MakeType>
-	VariantHeir& operator=(const std::initializer_list<MakeType>& list) {
+	constexpr VariantHeir& operator=(const std::initializer_list<MakeType>& list) {
 		VariantHeir* ptr = static_cast<VariantHeir*>(this);
-		VariantUnion<Types...> union_tmp;
-		static constexpr size_t index_of_type_of_variant_parent = union_tmp.template get_index_by_type<T>();
-		if (!ptr->non_empty) {
-			ptr->used_index = index_of_type_of_variant_parent;
-			ptr->non_empty = ptr->storage.template push<index_of_type_of_variant_parent>(list);
+		if (!ptr->non_empty()) {
+			ptr->template emplace_to_empty<index_of_type_of_variant_parent>(list);
 			return *ptr;
 		} else {
-			ptr->storage.destroy(ptr->used_index);
-			ptr->used_index = index_of_type_of_variant_parent;
-			ptr->non_empty = ptr->storage.template push<index_of_type_of_variant_parent>(list);
+			ptr->template replace<index_of_type_of_variant_parent>(list);
 			return *ptr;
 		}
 	}
 	
 	template <typename... Args, typename = std::enable_if_t<
 		std::conjunction_v<
+			std::bool_constant<(sizeof...(Args) != 1 || (!VariantConvertible<Args, Types...> && ...))>,
 			std::is_constructible<T, Args...>,
 			std::disjunction<
 				std::negation<std::is_constructible<Types, Args...>>,
@@ -247,277 +453,438 @@ public:
 			>...
 		>
 	>>
-	VariantHeir& operator=(Args&&... args) {
+	constexpr VariantHeir& operator=(Args&&... args) {
 		VariantHeir* ptr = static_cast<VariantHeir*>(this);
-		VariantUnion<Types...> union_tmp;
-		static constexpr size_t index_of_type_of_variant_parent = union_tmp.template get_index_by_type<T>();
-		if (!ptr->non_empty) {
-			ptr->used_index = index_of_type_of_variant_parent;
-			ptr->non_empty = ptr->storage.template push<index_of_type_of_variant_parent>(args...);
+		if (!ptr->non_empty()) {
+			ptr->template emplace_to_empty<index_of_type_of_variant_parent>(std::forward<Args>(args)...);
 			return *ptr;
 		} else {
-			ptr->storage.destroy(ptr->used_index);
-			ptr->used_index = index_of_type_of_variant_parent;
-			ptr->non_empty = ptr->storage.template push<index_of_type_of_variant_parent>(args...);
+			ptr->template replace<index_of_type_of_variant_parent>(std::forward<Args>(args)...);
 			return *ptr;
 		}
 	}
 	
-	void copy_union(const VariantUnion<Types...>& vu, size_t ind, bool non_emp) {
-		VariantUnion<Types...> union_tmp;
-		static constexpr size_t index_of_type_of_variant_parent = union_tmp.template get_index_by_type<T>();
-		if ((ind == index_of_type_of_variant_parent) && non_emp) {
-			VariantHeir* ptr = static_cast<VariantHeir*>(this);
-			ptr->non_empty = ptr->storage.template push<index_of_type_of_variant_parent>(
-					vu.template get<index_of_type_of_variant_parent>()
-			);
-		}
-	}
-	
-	void move_union(VariantUnion<Types...>& vu, size_t ind, bool non_emp) {
-		VariantUnion<Types...> union_tmp;
-		static constexpr size_t index_of_type_of_variant_parent = union_tmp.template get_index_by_type<T>();
-		if ((ind == index_of_type_of_variant_parent) && non_emp) {
-			VariantHeir* ptr = static_cast<VariantHeir*>(this);
-			ptr->non_empty = ptr->storage.template push<index_of_type_of_variant_parent>(
-					vu.template get<index_of_type_of_variant_parent>()
-			);
-			vu.destroy(index_of_type_of_variant_parent);
-			try {
-				vu.template push<index_of_type_of_variant_parent>();
-				vu.destroy(index_of_type_of_variant_parent);
-			} catch(...) {}
-		}
-	}
-	
 };
 
 template <typename... Types>
-class Variant : private VariantParent<Types, Types...>... {
+class Variant : private VariantStorage<Types...>, private VariantParent<Types, Types...>... {
 
 private:
 	template <typename T, typename... Ts>
 	friend class VariantParent;
 
 private:
-	VariantUnion<Types...> storage;
-	size_t used_index;
-	//index of used type
-	bool non_empty;
-	//flag: does this element exist
+	using VariantStorage<Types...>::storage;
+	using VariantStorage<Types...>::used_index;
+	using VariantStorage<Types...>::non_empty;
+	using VariantStorage<Types...>::set_used_index;
+	using VariantStorage<Types...>::kValueless;
 
 public:
-	Variant() {
-		used_index = 0;
-		non_empty = storage.template push<0>();
+	constexpr Variant() {
+		this->template emplace_to_empty<0>();
 	}
 
 	using VariantParent<Types, Types...>::VariantParent...;
 	using ::VariantParent<Types, Types...>::operator=...;
+	//VariantParent<T> makes T from initializer list or from arguments which only T accepts
 
-	Variant(const Variant& variant) : VariantParent<Types, Types...>(variant)... {
-		used_index = variant.used_index;
-		non_empty = variant.non_empty;
-		(::VariantParent<Types, Types...>::copy_union(variant.storage, variant.used_index, variant.non_empty), ...);
+	template <typename U>
+	requires (!std::is_same_v<std::remove_cvref_t<U>, Variant>) && VariantConvertible<U, Types...>
+	constexpr Variant(U&& value) {
+		//alternative is chosen as by std::variant, value goes to storage without temporary
+		this->template emplace_to_empty<VariantConvertingIndex<U, Types...>::value>(std::forward<U>(value));
 	}
 
-	Variant(Variant&& variant) {
-		used_index = variant.used_index;
-		non_empty = variant.non_empty;
-		(::VariantParent<Types, Types...>::move_union(variant.storage, variant.used_index, variant.non_empty), ...);
+	template <size_t I, typename... Args>
+	constexpr explicit Variant(std::in_place_index_t<I>, Args&&... args) {
+		this->template emplace_to_empty<I>(std::forward<Args>(args)...);
 	}
 
-	Variant& operator=(const Variant& variant) {
-		if (non_empty) {
-			storage.destroy(used_index);
+	template <size_t I, typename MakeType, typename... Args>
+	constexpr explicit Variant(std::in_place_index_t<I>, std::initializer_list<MakeType> list, Args&&... args) {
+		this->template emplace_to_empty<I>(list, std::forward<Args>(args)...);
+	}
+
+	template <typename T, typename... Args>
+	constexpr explicit Variant(std::in_place_type_t<T>, Args&&... args)
+			: Variant(std::in_place_index<variant_index_of_v<T, Types...>>, std::forward<Args>(args)...) {}
+
+	template <typename T, typename MakeType, typename... Args>
+	constexpr explicit Variant(std::in_place_type_t<T>, std::initializer_list<MakeType> list, Args&&... args)
+			: Variant(std::in_place_index<variant_index_of_v<T, Types...>>, list, std::forward<Args>(args)...) {}
+
+	template <typename U>
+	requires (!std::is_same_v<std::remove_cvref_t<U>, Variant>) && VariantConvertible<U, Types...>
+	constexpr Variant& operator=(U&& value) {
+		constexpr size_t I = VariantConvertingIndex<U, Types...>::value;
+		if (non_empty() && used_index == I) {
+			storage().template get<I>() = std::forward<U>(value);
+			//if throw all is OK
+		} else {
+			this->template replace<I>(std::forward<U>(value));
 		}
-		used_index = variant.used_index;
-		non_empty = variant.non_empty;
-		(::VariantParent<Types, Types...>::copy_union(variant.storage, variant.used_index, variant.non_empty), ...);
 		return *this;
 	}
 
-	Variant& operator=(Variant&& variant) {
-		if (non_empty) {
-			storage.destroy(used_index);
-		} 
-		used_index = variant.used_index;
-		non_empty = variant.non_empty;
-		(::VariantParent<Types, Types...>::move_union(variant.storage, variant.used_index, variant.non_empty), ...);
+	//if all types are trivial, Variant is trivial too and can be copied by memcpy
+	//else all operations use tables of VariantOperations
+
+	Variant(const Variant&) requires (std::is_trivially_copy_constructible_v<Types> && ...) = default;
+
+	constexpr Variant(const Variant& variant) : VariantStorage<Types...>(), VariantParent<Types, Types...>()... {
+		if (variant.non_empty()) {
+			VariantOperations<Types...>::copy_construct(*this, variant.storage(), variant.used_index);
+		}
+	}
+
+	Variant(Variant&&) requires (std::is_trivially_move_constructible_v<Types> && ...) = default;
+
+	constexpr Variant(Variant&& variant) noexcept((std::is_nothrow_move_constructible_v<Types> && ...))
+			: VariantStorage<Types...>(), VariantParent<Types, Types...>()... {
+		if (variant.non_empty()) {
+			VariantOperations<Types...>::move_construct(*this, variant.storage(), variant.used_index);
+		}
+	}
+
+	Variant& operator=(const Variant&) requires (std::is_trivially_copy_constructible_v<Types> && ...) &&
+			(std::is_trivially_copy_assignable_v<Types> && ...) &&
+			(std::is_trivially_destructible_v<Types> && ...) = default;
+
+	constexpr Variant& operator=(const Variant& variant) {
+		if (this == &variant) {
+			return *this;
+		}
+		if (non_empty() && variant.non_empty() && used_index == variant.used_index) {
+			VariantOperations<Types...>::copy_assign(storage(), variant.storage(), used_index);
+			//if throw all is OK
+			return *this;
+		}
+		if (variant.non_empty()) {
+			VariantOperations<Types...>::copy_replace(*this, variant.storage(), variant.used_index);
+		} else if (non_empty()) {
+			storage().destroy(used_index);
+			used_index = kValueless;
+		}
+		return *this;
+	}
+
+	Variant& operator=(Variant&&) requires (std::is_trivially_move_constructible_v<Types> && ...) &&
+			(std::is_trivially_move_assignable_v<Types> && ...) &&
+			(std::is_trivially_destructible_v<Types> && ...) = default;
+
+	constexpr Variant& operator=(Variant&& variant) noexcept((std::is_nothrow_move_constructible_v<Types> && ...) &&
+			(std::is_nothrow_move_assignable_v<Types> && ...)) {
+		if (this == &variant) {
+			return *this;
+		}
+		if (non_empty() && variant.non_empty() && used_index == variant.used_index) {
+			VariantOperations<Types...>::move_assign(storage(), variant.storage(), used_index);
+			return *this;
+		}
+		if (variant.non_empty()) {
+			VariantOperations<Types...>::move_replace(*this, variant.storage(), variant.used_index);
+		} else if (non_empty()) {
+			storage().destroy(used_index);
+			used_index = kValueless;
+		}
 		return *this;
 	}
 	
-	~Variant() {
-		if (non_empty) {
-			storage.destroy(used_index);
+	~Variant() requires (std::is_trivially_destructible_v<Types> && ...) = default;
+
+	constexpr ~Variant() {
+		if (non_empty()) {
+			storage().destroy(used_index);
 		}
 	}
 
-	template <size_t I, typename... Args>
-	auto& emplace(Args&&... args) {
-		if (non_empty) {
-			storage.destroy(used_index);
+	constexpr void swap(Variant& variant) {
+		if (non_empty() && variant.non_empty() && used_index == variant.used_index) {
+			VariantOperations<Types...>::swap(storage(), variant.storage(), used_index);
+			return;
 		}
-		used_index = I;
-		non_empty = storage.template push<I>(args...);
-		return storage.template get<I>();
+		Variant tmp(std::move(variant));
+		variant = std::move(*this);
+		*this = std::move(tmp);
+	}
+
+	template <size_t I, typename... Args>
+	constexpr auto& emplace(Args&&... args) {
+		this->template replace<I>(std::forward<Args>(args)...);
+		return storage().template get<I>();
 	}
 	
 	template <typename T, typename... Args>
-	T& emplace(Args&&... args) {
-		VariantUnion<Types...> union_tmp;
-		static constexpr size_t I = union_tmp.template get_index_by_type<T>();
-		return emplace<I>(args...);
+	constexpr T& emplace(Args&&... args) {
+		return emplace<variant_index_of_v<T, Types...>>(std::forward<Args>(args)...);
 	}
 	
 	template <size_t I, typename MakeType>
-	auto& emplace(std::initializer_list<MakeType> list) {
-		if (non_empty) {
-			storage.destroy(used_index);
-		}
-		used_index = I;
-		non_empty = storage.template push<I>(list);
-		return storage.template get<I>();
+	constexpr auto& emplace(std::initializer_list<MakeType> list) {
+		this->template replace<I>(list);
+		return storage().template get<I>();
 	}
 	
 	template <typename T, typename MakeType>
-	T& emplace(std::initializer_list<MakeType> list) {
-		VariantUnion<Types...> union_tmp;
-		static constexpr size_t I = union_tmp.template get_index_by_type<T>();
-		return emplace<I>(list);
+	constexpr T& emplace(std::initializer_list<MakeType> list) {
+		return emplace<variant_index_of_v<T, Types...>>(list);
 	}
 	
-	size_t index() const {
-		return used_index;
+	constexpr size_t index() const {
+		return non_empty() ? used_index : variant_npos;
 	}
 	
-	bool valueless_by_exception() const {
-		return !non_empty;
+	constexpr bool valueless_by_exception() const {
+		//always false if VariantPolicy<Types...>::never_valueless
+		return !non_empty();
 	}
 	
 private:
-	template <typename T, typename... Ts>
-	friend bool holds_alternative(const Variant<Ts...>&);
-	
-	template <typename T, typename... Ts>
-	friend bool holds_alternative(const Variant<Ts...>&&);
-	
-	template <typename T, typename... Ts>
-	friend T& get(Variant<Ts...>&);
-
-	template <typename T, typename... Ts>
-	friend const T& get(const Variant<Ts...>&);
-
-	template <typename T, typename... Ts>
-	friend T&& get(Variant<Ts...>&&);
+	friend struct VariantAccess;
 
-	template <typename T, typename... Ts>
-	friend const T&& get(const Variant<Ts...>&&);
+};
 
-	template <size_t I, typename... Ts>
-	friend auto& get(Variant<Ts...>&);
+template <size_t I, typename... Types>
+using VariantAlternative = std::tuple_element_t<I, std::tuple<Types...>>;
 
-	template <size_t I, typename... Ts>
-	friend const auto& get(const Variant<Ts...>&);
+struct VariantAccess {
+	//access to element without check of index
+	template <size_t I, typename... Types>
+	static constexpr auto& get(Variant<Types...>& variant) {
+		return variant.storage().template get<I>();
+	}
 
-	template <size_t I, typename... Ts>
-	friend auto&& get(Variant<Ts...>&&);
+	template <size_t I, typename... Types>
+	static constexpr const auto& get(const Variant<Types...>& variant) {
+		return variant.storage().template get<I>();
+	}
 
-	template <size_t I, typename... Ts>
-	friend const auto&& get(const Variant<Ts...>&&);
+	template <size_t I, typename... Types>
+	static constexpr auto&& get(Variant<Types...>&& variant) {
+		return std::move(variant.storage().template get<I>());
+	}
 
+	template <size_t I, typename... Types>
+	static constexpr const auto&& get(const Variant<Types...>&& variant) {
+		return std::move(variant.storage().template get<I>());
+	}
 };
 
 template <typename T, typename... Types>
-bool holds_alternative(const Variant<Types...>& variant) {
-	VariantUnion<Types...> union_tmp;
-	static constexpr size_t index = union_tmp.template get_index_by_type<T>();
-	return (index == variant.used_index) ? true : false;
+constexpr bool holds_alternative(const Variant<Types...>& variant) {
+	return variant.index() == variant_index_of_v<T, Types...>;
 }
 
 template <typename T, typename... Types>
-bool holds_alternative(const Variant<Types...>&& variant) {
-	VariantUnion<Types...> union_tmp;
-	static constexpr size_t index = union_tmp.template get_index_by_type<T>();
-	return (index == variant.used_index) ? true : false;
+constexpr bool holds_alternative(const Variant<Types...>&& variant) {
+	return variant.index() == variant_index_of_v<T, Types...>;
+}
+
+template <size_t I, typename... Types>
+constexpr auto& get(Variant<Types...>& variant) {
+	if (variant.index() != I)
+		throw_bad_variant_access("This type does not used now");
+	return VariantAccess::get<I>(variant);
+}
+
+template <size_t I, typename... Types>
+constexpr const auto& get(const Variant<Types...>& variant) {
+	if (variant.index() != I)
+		throw_bad_variant_access("This type does not used now");
+	return VariantAccess::get<I>(variant);
+}
+
+template <size_t I, typename... Types>
+constexpr auto&& get(Variant<Types...>&& variant) {
+	if (variant.index() != I)
+		throw_bad_variant_access("This type does not used now");
+	return VariantAccess::get<I>(std::move(variant));
+}
+
+template <size_t I, typename... Types>
+constexpr const auto&& get(const Variant<Types...>&& variant) {
+	if (variant.index() != I)
+		throw_bad_variant_access("This type does not used now");
+	return VariantAccess::get<I>(std::move(variant));
 }
 
 template <typename T, typename... Types>
-T& get(Variant<Types...>& variant) {
-	bool flag = holds_alternative<T>(variant);
-	VariantUnion<Types...> union_tmp;
-	static constexpr size_t index = union_tmp.template get_index_by_type<T>();
-	if (!flag)
-		throw "This type does not used now";
-	T& answer = variant.storage.template get<index>();
-	return answer;
+constexpr T& get(Variant<Types...>& variant) {
+	return get<variant_index_of_v<T, Types...>>(variant);
 }
 
 template <typename T, typename... Types>
-const T& get(const Variant<Types...>& variant) {
-	bool flag = holds_alternative<T>(variant);
-	VariantUnion<Types...> union_tmp;
-	static constexpr size_t index = union_tmp.template get_index_by_type<T>();
-	if (!flag)
-		throw "This type does not used now";
-	T& answer = variant.storage.template get<index>();
-	return answer;
+constexpr const T& get(const Variant<Types...>& variant) {
+	return get<variant_index_of_v<T, Types...>>(variant);
 }
 
 template <typename T, typename... Types>
-T&& get(Variant<Types...>&& variant) {
-	bool flag = holds_alternative<T>(variant);
-	VariantUnion<Types...> union_tmp;
-	static constexpr size_t index = union_tmp.template get_index_by_type<T>();
-	if (!flag)
-		throw "This type does not used now";
-	T& answer = variant.storage.template get<index>();
-	return std::move(answer);
+constexpr T&& get(Variant<Types...>&& variant) {
+	return get<variant_index_of_v<T, Types...>>(std::move(variant));
 }
 
 template <typename T, typename... Types>
-const T&& get(const Variant<Types...>&& variant) {
-	bool flag = holds_alternative<T>(variant);
-	VariantUnion<Types...> union_tmp;
-	static constexpr size_t index = union_tmp.template get_index_by_type<T>();
-	if (!flag)
-		throw "This type does not used now";
-	T& answer = variant.storage.template get<index>();
-	return std::move(answer);
+constexpr const T&& get(const Variant<Types...>&& variant) {
+	return get<variant_index_of_v<T, Types...>>(std::move(variant));
 }
 
+//get_if returns nullptr instead of exception
+
 template <size_t I, typename... Types>
-auto& get(Variant<Types...>& variant) {
-	bool flag = (variant.used_index == I);
-	if (!flag)
-		throw "This type does not used now";
-	auto& answer = variant.storage.template get<I>();
-	return answer;
+constexpr VariantAlternative<I, Types...>* get_if(Variant<Types...>* variant) {
+	if (variant == nullptr || variant->index() != I)
+		return nullptr;
+	return &VariantAccess::get<I>(*variant);
 }
 
 template <size_t I, typename... Types>
-const auto& get(const Variant<Types...>& variant) {
-	bool flag = (variant.used_index == I);
-	if (!flag)
-		throw "This type does not used now";
-	auto& answer = variant.storage.template get<I>();
-	return answer;
+constexpr const VariantAlternative<I, Types...>* get_if(const Variant<Types...>* variant) {
+	if (variant == nullptr || variant->index() != I)
+		return nullptr;
+	return &VariantAccess::get<I>(*variant);
+}
+
+template <typename T, typename... Types>
+constexpr T* get_if(Variant<Types...>* variant) {
+	return get_if<variant_index_of_v<T, Types...>>(variant);
+}
+
+template <typename T, typename... Types>
+constexpr const T* get_if(const Variant<Types...>* variant) {
+	return get_if<variant_index_of_v<T, Types...>>(variant);
+}
+
+//get_unsafe does not check index, only assert in debug build
+//for hot paths where index is already known
+
+template <size_t I, typename... Types>
+constexpr auto& get_unsafe(Variant<Types...>& variant) {
+	assert(variant.index() == I);
+	return VariantAccess::get<I>(variant);
 }
 
 template <size_t I, typename... Types>
-auto&& get(Variant<Types...>&& variant) {
-	bool flag = (variant.used_index == I);
-	if (!flag)
-		throw "This type does not used now";
-	auto& answer = variant.storage.template get<I>();
-	return std::move(answer);
+constexpr const auto& get_unsafe(const Variant<Types...>& variant) {
+	assert(variant.index() == I);
+	return VariantAccess::get<I>(variant);
 }
 
 template <size_t I, typename... Types>
-const auto&& get(const Variant<Types...>&& variant) {
-	bool flag = (variant.used_index == I);
-	if (!flag)
-		throw "This type does not used now";
-	auto& answer = variant.storage.template get<I>();
-	return std::move(answer);
+constexpr auto&& get_unsafe(Variant<Types...>&& variant) {
+	assert(variant.index() == I);
+	return VariantAccess::get<I>(std::move(variant));
+}
+
+template <typename T, typename... Types>
+constexpr T& get_unsafe(Variant<Types...>& variant) {
+	return get_unsafe<variant_index_of_v<T, Types...>>(variant);
+}
+
+template <typename T, typename... Types>
+constexpr const T& get_unsafe(const Variant<Types...>& variant) {
+	return get_unsafe<variant_index_of_v<T, Types...>>(variant);
+}
+
+template <typename T, typename... Types>
+constexpr T&& get_unsafe(Variant<Types...>&& variant) {
+	return get_unsafe<variant_index_of_v<T, Types...>>(std::move(variant));
+}
+
+//Visit:
+//visit(f, v1, ..., vk) calls f(get<I1>(v1), ..., get<Ik>(vk)) for active alternatives
+//all combinations of indices are put in one compile-time table of function pointers
+//index in the table is ((I1 * n2 + I2) * n3 + I3) ..., so call is O(1) for any number of alternatives
+//result is common type of results of all combinations
+
+template <typename V>
+struct VariantSize;
+
+template <typename... Types>
+struct VariantSize<Variant<Types...>> : std::integral_constant<size_t, sizeof...(Types)> {};
+
+template <typename V>
+static constexpr size_t variant_size_v = VariantSize<std::remove_cv_t<std::remove_reference_t<V>>>::value;
+
+template <bool all_the_same, typename Head, typename... Tail>
+struct VisitResultImpl {
+	using type = Head;
+};
+
+template <typename Head, typename... Tail>
+struct VisitResultImpl<false, Head, Tail...> {
+	using type = std::common_type_t<Head, Tail...>;
+};
+
+template <typename Head, typename... Tail>
+struct VisitResult {
+	//the same type if all results are the same, common type else
+	using type = typename VisitResultImpl<(std::is_same_v<Head, Tail> && ...), Head, Tail...>::type;
+};
+
+template <typename Visitor, typename... Variants>
+struct VisitTable {
+	static constexpr size_t sizes[] = {variant_size_v<Variants>..., 1};
+	//last 1 only for empty list of variants
+
+	static constexpr size_t size = (variant_size_v<Variants> * ... * 1);
+
+	template <size_t K, size_t J>
+	static constexpr size_t index_of_variant() {
+		//index of alternative of variant J in combination K
+		size_t divisor = 1;
+		for (size_t j = J + 1; j < sizeof...(Variants); ++j) {
+			divisor *= sizes[j];
+		}
+		return (K / divisor) % sizes[J];
+	}
+
+	template <size_t... Is>
+	static constexpr decltype(auto) invoke_combination(Visitor&& visitor, Variants&&... variants) {
+		return std::forward<Visitor>(visitor)(VariantAccess::get<Is>(std::forward<Variants>(variants))...);
+	}
+
+	template <size_t K, size_t... Js>
+	static constexpr auto combination(std::index_sequence<Js...>) {
+		//pointer to invoke_combination for combination K
+		return &VisitTable::invoke_combination<index_of_variant<K, Js>()...>;
+	}
+
+	template <size_t K>
+	using ResultOfCombination = decltype(
+		std::declval<decltype(combination<K>(std::index_sequence_for<Variants...>()))>()(
+			std::declval<Visitor>(), std::declval<Variants>()...
+		)
+	);
+
+	template <size_t... Ks>
+	static auto result(std::index_sequence<Ks...>) -> typename VisitResult<ResultOfCombination<Ks>...>::type;
+
+	using Result = decltype(result(std::make_index_sequence<size>()));
+
+	template <size_t K>
+	static constexpr Result invoke(Visitor&& visitor, Variants&&... variants) {
+		return combination<K>(std::index_sequence_for<Variants...>())(
+			std::forward<Visitor>(visitor), std::forward<Variants>(variants)...
+		);
+	}
+
+	using Function = Result (*)(Visitor&&, Variants&&...);
+
+	template <size_t... Ks>
+	static constexpr std::array<Function, size> make_table(std::index_sequence<Ks...>) {
+		return {&VisitTable::invoke<Ks>...};
+	}
+
+	static constexpr std::array<Function, size> table = make_table(std::make_index_sequence<size>());
+};
+
+template <typename Visitor, typename... Variants>
+constexpr decltype(auto) visit(Visitor&& visitor, Variants&&... variants) {
+	using Table = VisitTable<Visitor&&, Variants&&...>;
+	if ((variants.valueless_by_exception() || ...))
+		throw_bad_variant_access("Variant is valueless");
+	size_t index = 0;
+	((index = index * variant_size_v<Variants> + variants.index()), ...);
+	return Table::table[index](std::forward<Visitor>(visitor), std::forward<Variants>(variants)...);
 }
@@ -0,0 +1,120 @@
+//needs C++20, as variant.h
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "variant.h"
+
+//Micro-benchmarks of Variant against std::variant: construct, assign, get, destroy and copy
+//both are tested with the same code on the same alternatives, nanoseconds per operation are printed
+//usage: variant_benchmark [operations]
+
+template <typename V>
+struct Benchmark {
+	size_t operations;
+	long long checksum = 0;
+	//results go to checksum, so compiler can not throw operations away
+
+	double seconds_from(std::chrono::steady_clock::time_point begin) const {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	}
+
+	double construct_and_destroy() {
+		//construct and destroy in one buffer, alternatives in turn
+		alignas(V) unsigned char buffer[sizeof(V)];
+		auto begin = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < operations; ++i) {
+			V* variant;
+			if (i % 3 == 0) {
+				variant = new(buffer) V(static_cast<int>(i));
+			} else if (i % 3 == 1) {
+				variant = new(buffer) V(static_cast<double>(i));
+			} else {
+				variant = new(buffer) V(std::string("short"));
+			}
+			checksum += variant->index();
+			variant->~V();
+		}
+		return seconds_from(begin);
+	}
+
+	double assign() {
+		//assignment of values which change alternative and which keep it
+		V variant(0);
+		std::string text = "short";
+		auto begin = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < operations; ++i) {
+			switch (i % 4) {
+				case 0: variant = static_cast<int>(i); break;
+				case 1: variant = static_cast<int>(i + 1); break;
+				case 2: variant = text; break;
+				default: variant = static_cast<double>(i); break;
+			}
+			checksum += variant.index();
+		}
+		return seconds_from(begin);
+	}
+
+	double get_alternative() {
+		//checked get of known alternative
+		std::vector<V> variants;
+		for (size_t i = 0; i < 1024; ++i) {
+			variants.emplace_back(static_cast<int>(i));
+		}
+		auto begin = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < operations; ++i) {
+			checksum += get<0>(variants[i % variants.size()]);
+		}
+		return seconds_from(begin);
+	}
+
+	double copy() {
+		//copy construction and copy assignment of mixed alternatives
+		std::vector<V> variants;
+		for (size_t i = 0; i < 64; ++i) {
+			if (i % 2 == 0) {
+				variants.emplace_back(static_cast<int>(i));
+			} else {
+				variants.emplace_back(std::string("short"));
+			}
+		}
+		V target(0);
+		auto begin = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < operations; ++i) {
+			const V& source = variants[i % variants.size()];
+			V copy_of_source(source);
+			target = copy_of_source;
+			checksum += target.index();
+		}
+		return seconds_from(begin);
+	}
+};
+
+int main(int argc, char** argv) {
+	size_t operations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+
+	Benchmark<Variant<int, double, std::string>> ours{operations};
+	Benchmark<std::variant<int, double, std::string>> standard{operations};
+	const double per_operation = 1e9 / operations;
+
+	std::printf("Variant<int, double, std::string>, %zu operations\n", operations);
+	std::printf("%-24s %12s %16s %8s\n", "", "Variant ns", "std::variant ns", "ratio");
+	auto report = [per_operation](const char* name, double ours_seconds, double standard_seconds) {
+		std::printf("%-24s %12.2f %16.2f %8.2f\n", name, ours_seconds * per_operation,
+				standard_seconds * per_operation, ours_seconds / standard_seconds);
+	};
+	report("construct + destroy", ours.construct_and_destroy(), standard.construct_and_destroy());
+	report("assign", ours.assign(), standard.assign());
+	report("get", ours.get_alternative(), standard.get_alternative());
+	report("copy", ours.copy(), standard.copy());
+
+	if (ours.checksum != standard.checksum) {
+		std::printf("checksums differ: %lld and %lld\n", ours.checksum, standard.checksum);
+		return 1;
+	}
+	return 0;
+}
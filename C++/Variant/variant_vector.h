@@ -0,0 +1,145 @@
+#pragma once
+//needs C++20, as variant.h
+
+#include <vector>
+#include <tuple>
+#include <array>
+#include <utility>
+#include <type_traits>
+
+#include "variant.h"
+
+template <typename... Types>
+class VariantVector {
+	//structure of arrays for sequence of Variant<Types...>
+	//every type is stored in its own contiguous vector without padding to the largest type
+	//order of elements is stored in types: one small index per element
+	//for_each_type<T> goes through one vector, it has no branches and can be vectorized
+	//for_each goes through elements in order of insertion
+
+	static_assert(!(std::is_same_v<Types, bool> || ...), "std::vector<bool> does not give references to elements");
+
+private:
+	using IndexType = VariantIndexType<sizeof...(Types)>;
+
+	std::tuple<std::vector<Types>...> columns;
+	std::vector<IndexType> types;
+	//types[i] is index of type of i-th element
+	//position of i-th element in its vector is number of elements of the same type before it
+
+	template <typename Visitor, size_t... Is>
+	void for_each_impl(Visitor&& visitor, std::index_sequence<Is...>) {
+		std::array<size_t, sizeof...(Types)> positions{};
+		for (IndexType type : types) {
+			//only one expression of fold is called
+			((type == Is ? (visitor(std::get<Is>(columns)[positions[Is]++]), true) : false) || ...);
+		}
+	}
+
+	template <typename Visitor, size_t... Is>
+	void for_each_impl(Visitor&& visitor, std::index_sequence<Is...>) const {
+		std::array<size_t, sizeof...(Types)> positions{};
+		for (IndexType type : types) {
+			((type == Is ? (visitor(std::get<Is>(columns)[positions[Is]++]), true) : false) || ...);
+		}
+	}
+
+public:
+	VariantVector() = default;
+
+	template <typename T, typename... Args>
+	T& emplace_back(Args&&... args) {
+		constexpr size_t I = variant_index_of_v<T, Types...>;
+		T& answer = std::get<I>(columns).emplace_back(std::forward<Args>(args)...);
+		try {
+			types.push_back(static_cast<IndexType>(I));
+		} catch(...) {
+			std::get<I>(columns).pop_back();
+			throw;
+		}
+		return answer;
+	}
+
+	template <typename T>
+	requires (!std::is_same_v<std::remove_cvref_t<T>, Variant<Types...>>)
+	void push_back(T&& value) {
+		emplace_back<std::remove_cvref_t<T>>(std::forward<T>(value));
+	}
+
+	void push_back(const Variant<Types...>& variant) {
+		visit([this](const auto& value) {
+			push_back(value);
+		}, variant);
+	}
+
+	template <typename T>
+	std::vector<T>& column() {
+		constexpr size_t I = variant_index_of_v<T, Types...>;
+		return std::get<I>(columns);
+	}
+
+	template <typename T>
+	const std::vector<T>& column() const {
+		constexpr size_t I = variant_index_of_v<T, Types...>;
+		return std::get<I>(columns);
+	}
+
+	template <typename T, typename Function>
+	void for_each_type(Function&& function) {
+		//all elements of type T, in order of insertion
+		for (T& value : column<T>()) {
+			function(value);
+		}
+	}
+
+	template <typename T, typename Function>
+	void for_each_type(Function&& function) const {
+		for (const T& value : column<T>()) {
+			function(value);
+		}
+	}
+
+	template <typename Visitor>
+	void for_each(Visitor&& visitor) {
+		//all elements in order of insertion, visitor must accept all types
+		for_each_impl(visitor, std::index_sequence_for<Types...>());
+	}
+
+	template <typename Visitor>
+	void for_each(Visitor&& visitor) const {
+		for_each_impl(visitor, std::index_sequence_for<Types...>());
+	}
+
+	size_t type_index(size_t i) const {
+		return types[i];
+	}
+
+	template <typename T>
+	size_t count() const {
+		return column<T>().size();
+	}
+
+	size_t size() const {
+		return types.size();
+	}
+
+	bool empty() const {
+		return types.empty();
+	}
+
+	void reserve(size_t new_capacity) {
+		types.reserve(new_capacity);
+	}
+
+	template <typename T>
+	void reserve(size_t new_capacity) {
+		column<T>().reserve(new_capacity);
+	}
+
+	void clear() {
+		std::apply([](auto&... vectors) {
+			(vectors.clear(), ...);
+		}, columns);
+		types.clear();
+	}
+};
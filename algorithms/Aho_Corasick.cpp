@@ -1,8 +1,9 @@
 #include <deque>
-#include <iostream>
 #include <string>
 #include <vector>
 
+#include "fast_io.h"
+
 namespace constants {
 static const int kSigma = 26;
 static const int kLinkNil = -1;
@@ -106,14 +107,14 @@ class Trie {
 
 int main() {
   std::string str;
-  std::cin >> str;
+  fast_io::In() >> str;
 
   Trie forest;
   int dictionary_size;
-  std::cin >> dictionary_size;
+  fast_io::In() >> dictionary_size;
   for (int i = 0; i < dictionary_size; ++i) {
     std::string tmp;
-    std::cin >> tmp;
+    fast_io::In() >> tmp;
     forest.Add(tmp, i);
   }
   forest.AhoCorasick();
@@ -121,13 +122,13 @@ int main() {
   auto answer = std::move(forest.CalculateOccurrences(str, dictionary_size));
   for (size_t i = 0; i < answer.size(); ++i) {
     if (answer[i].empty()) {
-      std::cout << 0 << '\n';
+      fast_io::Out() << 0 << '\n';
     } else {
-      std::cout << answer[i].size();
+      fast_io::Out() << answer[i].size();
       for (size_t j = 0; j < answer[i].size(); ++j) {
-        std::cout << ' ' << answer[i][j];
+        fast_io::Out() << ' ' << answer[i][j];
       }
-      std::cout << '\n';
+      fast_io::Out() << '\n';
     }
   }
 }
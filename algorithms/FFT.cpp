@@ -1,9 +1,10 @@
 #include <cassert>
 #include <cmath>
 #include <complex>
-#include <iostream>
 #include <vector>
 
+#include "fast_io.h"
+
 template <typename Element>
 class Field {
  public:
@@ -238,16 +239,16 @@ class Polynom {
 
 int main() {
   int polynom_a_deg;
-  std::cin >> polynom_a_deg;
+  fast_io::In() >> polynom_a_deg;
   std::vector<int> polynom_a(polynom_a_deg + 1);
   for (int i = 0; i <= polynom_a_deg; ++i) {
-    std::cin >> polynom_a[i];
+    fast_io::In() >> polynom_a[i];
   }
   int polynom_b_deg;
-  std::cin >> polynom_b_deg;
+  fast_io::In() >> polynom_b_deg;
   std::vector<int> polynom_b(polynom_b_deg + 1);
   for (int i = 0; i <= polynom_b_deg; ++i) {
-    std::cin >> polynom_b[i];
+    fast_io::In() >> polynom_b[i];
   }
 
   Polynom<int> polynom_aa(polynom_a);
@@ -257,9 +258,9 @@ int main() {
   Polynom<int> polynom_cc =
       polynom_aa.Mul<std::complex<double>>(polynom_bb, complex_z);
 
-  std::cout << polynom_cc.Size() - 1 << ' ';
+  fast_io::Out() << polynom_cc.Size() - 1 << ' ';
   for (size_t i = 0; i < polynom_cc.Size(); ++i) {
-    std::cout << polynom_cc[i] << ' ';
+    fast_io::Out() << polynom_cc[i] << ' ';
   }
-  std::cout << '\n';
+  fast_io::Out() << '\n';
 }
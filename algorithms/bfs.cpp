@@ -0,0 +1,56 @@
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include <cassert>
+
+#include "fast_io.h"
+#include "graph.h"
+
+void printDistances(const BFSResult& result) {
+	for (int distance : result.distance) {
+		fast_io::Out() << distance << ' ';
+	}
+	fast_io::Out() << '\n';
+}
+
+int main(int argc, char** argv) {
+	//input: N M, M edges and source, vertices are numbered from 1
+	//or: bfs <binary graph file> <source>
+	//output: distance from source for every vertex, -1 if vertex is not reachable
+	if (argc == 3) {
+		try {
+			Graph<DFSVertex, mapped> graph(argv[1], true);
+			Graph<DFSVertex, csr> reverse_graph(graph.N);
+			makeReverseEdges(graph, reverse_graph);
+			int source = std::atoi(argv[2]) - 1;
+			if (source < 0 || source >= graph.N) {
+				std::cerr << "bad source vertex\n";
+				return 1;
+			}
+			printDistances(BFS(graph, reverse_graph, source));
+		} catch (const std::runtime_error& error) {
+			std::cerr << error.what() << '\n';
+			return 1;
+		}
+		return 0;
+	}
+
+	int N, M;
+	fast_io::In() >> N >> M;
+	Graph<DFSVertex, csr> graph(N);
+	std::vector<std::pair<int, int>> edge_list(M);
+	for (int i = 0; i < M; ++i) {
+		int a, b;
+		fast_io::In() >> a >> b;
+		edge_list[i] = {a-1, b-1};
+	}
+	int source;
+	fast_io::In() >> source;
+	graph.build_from_edges(edge_list);
+	Graph<DFSVertex, csr> reverse_graph(N);
+	makeReverseEdges(graph, reverse_graph);
+	printDistances(BFS(graph, reverse_graph, source-1));
+
+	return 0;
+}
@@ -1,7 +1,8 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
-#include <iostream>
+
+#include "fast_io.h"
 
 template <typename Number>
 struct Point {
@@ -91,13 +92,13 @@ Number CrossProduct(const Point<Number>& left, const Point<Number>& right) {
 }
 
 template <typename Number>
-std::istream& operator>>(std::istream& is, Point<Number>& p) {
+fast_io::Reader& operator>>(fast_io::Reader& is, Point<Number>& p) {
     is >> p.x >> p.y;
     return is;
 }
 
 template <typename Number>
-std::ostream& operator<<(std::ostream& os, const Point<Number>& p) {
+fast_io::Writer& operator<<(fast_io::Writer& os, const Point<Number>& p) {
     os << p.x << ' ' << p.y;
     return os;
 }
@@ -204,33 +205,33 @@ public:
     }
 
     void Print() {
-        /* std::cout << "Upper part of Convex hull\n";
+        /* fast_io::Out() << "Upper part of Convex hull\n";
         for (size_t i = 0; i < upper.size(); ++i) {
-            std::cout << upper[i] << '\n';
+            fast_io::Out() << upper[i] << '\n';
         }
 
-        std::cout << "Lower part of Convex hull\n";
+        fast_io::Out() << "Lower part of Convex hull\n";
         for (size_t i = 0; i < lower.size(); ++i) {
-            std::cout << lower[i] << '\n';
+            fast_io::Out() << lower[i] << '\n';
         } */
 
-        std::cout << upper.size()+lower.size()-2 << '\n';
+        fast_io::Out() << upper.size()+lower.size()-2 << '\n';
         for (size_t i = 0; i < upper.size(); ++i) {
-            std::cout << upper[i] << '\n';
+            fast_io::Out() << upper[i] << '\n';
         }
         for (size_t i = lower.size()-2; i > 0; --i) {
-            std::cout << lower[i] << '\n';
+            fast_io::Out() << lower[i] << '\n';
         }
     }
 };
 
 int main() {
     size_t N;
-    std::cin >> N;
+    fast_io::In() >> N;
 
     std::vector<Point<long long int>> points(N);
     for (size_t i = 0; i < N; ++i) {
-        std::cin >> points[i];
+        fast_io::In() >> points[i];
     }
 
     ConvexHull<long long int> convex_hull(std::move(points));
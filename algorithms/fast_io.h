@@ -0,0 +1,280 @@
+#pragma once
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace fast_io {
+
+static const size_t kBufferSize = 1 << 16;
+
+// Reads stdin (or any file descriptor) by big blocks and parses tokens
+// without iostream: integers, strings, chars and floating numbers.
+// Tokens are separated by whitespace, as for std::cin >>.
+class Reader {
+ public:
+  explicit Reader(int fd = STDIN_FILENO, size_t buffer_size = kBufferSize)
+      : fd_(fd), buffer_(buffer_size) {}
+
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+
+  template <typename Integer>
+  std::enable_if_t<std::is_integral_v<Integer> && !std::is_same_v<Integer, bool> &&
+                       !std::is_same_v<Integer, char>,
+                   Reader&>
+  operator>>(Integer& value) {
+    // as std::istream, failed extraction stores zero
+    value = 0;
+    if (!SkipSpaces()) {
+      failed_ = true;
+      return *this;
+    }
+    bool negative = false;
+    if (buffer_[position_] == '-' || buffer_[position_] == '+') {
+      negative = buffer_[position_] == '-';
+      ++position_;
+    }
+    using Unsigned = std::make_unsigned_t<Integer>;
+    Unsigned result = 0;
+    bool has_digits = false;
+    for (int c = Peek(); '0' <= c && c <= '9'; c = Peek()) {
+      result = result * 10 + static_cast<Unsigned>(c - '0');
+      has_digits = true;
+      ++position_;
+    }
+    if (!has_digits) {
+      failed_ = true;
+      return *this;
+    }
+    value = static_cast<Integer>(negative ? Unsigned(0) - result : result);
+    return *this;
+  }
+
+  template <typename Floating>
+  std::enable_if_t<std::is_floating_point_v<Floating>, Reader&> operator>>(
+      Floating& value) {
+    std::string token;
+    value = 0;
+    if (!ReadToken(token)) {
+      return *this;
+    }
+    char* end = nullptr;
+    if constexpr (std::is_same_v<Floating, float>) {
+      value = std::strtof(token.c_str(), &end);
+    } else if constexpr (std::is_same_v<Floating, double>) {
+      value = std::strtod(token.c_str(), &end);
+    } else {
+      value = std::strtold(token.c_str(), &end);
+    }
+    failed_ = failed_ || end != token.c_str() + token.size();
+    return *this;
+  }
+
+  Reader& operator>>(std::string& value) {
+    value.clear();
+    ReadToken(value);
+    return *this;
+  }
+
+  Reader& operator>>(char& value) {
+    if (!SkipSpaces()) {
+      failed_ = true;
+      return *this;
+    }
+    value = buffer_[position_++];
+    return *this;
+  }
+
+  explicit operator bool() const { return !failed_; }
+
+  // Number of bytes read from the file descriptor.
+  size_t BytesRead() const { return bytes_read_; }
+
+ private:
+  bool Refill() {
+    ssize_t size;
+    do {
+      size = read(fd_, buffer_.data(), buffer_.size());
+    } while (size < 0 && errno == EINTR);
+    position_ = 0;
+    size_ = size > 0 ? static_cast<size_t>(size) : 0;
+    bytes_read_ += size_;
+    return size_ > 0;
+  }
+
+  int Peek() {
+    if (position_ == size_ && !Refill()) {
+      return -1;
+    }
+    return static_cast<unsigned char>(buffer_[position_]);
+  }
+
+  bool SkipSpaces() {
+    // true if there is a token
+    for (int c = Peek(); c != -1; c = Peek()) {
+      if (c > ' ') {
+        return true;
+      }
+      ++position_;
+    }
+    return false;
+  }
+
+  bool ReadToken(std::string& token) {
+    if (!SkipSpaces()) {
+      failed_ = true;
+      return false;
+    }
+    while (true) {
+      size_t begin = position_;
+      while (position_ < size_ &&
+             static_cast<unsigned char>(buffer_[position_]) > ' ') {
+        ++position_;
+      }
+      token.append(buffer_.data() + begin, position_ - begin);
+      // token ends inside buffer or at the end of input
+      if (position_ < size_ || !Refill()) {
+        return true;
+      }
+    }
+  }
+
+  int fd_;
+  std::vector<char> buffer_;
+  size_t position_ = 0;
+  size_t size_ = 0;
+  size_t bytes_read_ = 0;
+  bool failed_ = false;
+};
+
+// Collects output in a big buffer and writes it by blocks.
+// Integers are formatted by hand, floating numbers as by std::cout (%g).
+class Writer {
+ public:
+  explicit Writer(int fd = STDOUT_FILENO, size_t buffer_size = kBufferSize)
+      : fd_(fd), buffer_(buffer_size) {}
+
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  ~Writer() { Flush(); }
+
+  template <typename Integer>
+  std::enable_if_t<std::is_integral_v<Integer> && !std::is_same_v<Integer, bool> &&
+                       !std::is_same_v<Integer, char>,
+                   Writer&>
+  operator<<(Integer value) {
+    using Unsigned = std::make_unsigned_t<Integer>;
+    Unsigned absolute = static_cast<Unsigned>(value);
+    char digits[24];
+    size_t length = 0;
+    if constexpr (std::is_signed_v<Integer>) {
+      if (value < 0) {
+        absolute = Unsigned(0) - absolute;
+        Put('-');
+      }
+    }
+    do {
+      digits[length++] = static_cast<char>('0' + absolute % 10);
+      absolute /= 10;
+    } while (absolute != 0);
+    Reserve(length);
+    while (length > 0) {
+      buffer_[size_++] = digits[--length];
+    }
+    return *this;
+  }
+
+  template <typename Floating>
+  std::enable_if_t<std::is_floating_point_v<Floating>, Writer&> operator<<(
+      Floating value) {
+    char text[64];
+    int length = std::snprintf(text, sizeof(text), "%Lg",
+                               static_cast<long double>(value));
+    Write(text, static_cast<size_t>(length));
+    return *this;
+  }
+
+  Writer& operator<<(bool value) { return *this << static_cast<int>(value); }
+
+  Writer& operator<<(char value) {
+    Put(value);
+    return *this;
+  }
+
+  Writer& operator<<(const char* value) {
+    Write(value, std::strlen(value));
+    return *this;
+  }
+
+  Writer& operator<<(const std::string& value) {
+    Write(value.data(), value.size());
+    return *this;
+  }
+
+  void Flush() {
+    WriteAll(buffer_.data(), size_);
+    size_ = 0;
+  }
+
+ private:
+  void Reserve(size_t length) {
+    if (size_ + length > buffer_.size()) {
+      Flush();
+    }
+  }
+
+  void Put(char c) {
+    Reserve(1);
+    buffer_[size_++] = c;
+  }
+
+  void Write(const char* data, size_t length) {
+    if (length > buffer_.size()) {
+      Flush();
+      WriteAll(data, length);
+      return;
+    }
+    Reserve(length);
+    std::memcpy(buffer_.data() + size_, data, length);
+    size_ += length;
+  }
+
+  void WriteAll(const char* data, size_t length) {
+    size_t written = 0;
+    while (written < length) {
+      ssize_t result = write(fd_, data + written, length - written);
+      if (result < 0 && errno == EINTR) {
+        continue;
+      }
+      if (result <= 0) {
+        break;
+      }
+      written += static_cast<size_t>(result);
+    }
+  }
+
+  int fd_;
+  std::vector<char> buffer_;
+  size_t size_ = 0;
+};
+
+// Shared stdin reader and stdout writer, the writer is flushed at exit.
+inline Reader& In() {
+  static Reader reader;
+  return reader;
+}
+
+inline Writer& Out() {
+  static Writer writer;
+  return writer;
+}
+
+}  // namespace fast_io
@@ -0,0 +1,91 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+
+#include "fast_io.h"
+
+// Throughput of fast_io against iostream on the same file of random integers.
+// Usage: fast_io_benchmark [count]
+
+namespace {
+
+double Seconds(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin)
+      .count();
+}
+
+void Report(const char* name, size_t bytes, double seconds, long long sum) {
+  std::printf("%-24s %8.1f MB/s  (checksum %lld)\n", name,
+              static_cast<double>(bytes) / (1 << 20) / seconds, sum);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+  std::string path = "/tmp/fast_io_benchmark.txt";
+
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int> distribution(-1000000000, 1000000000);
+
+  auto begin = std::chrono::steady_clock::now();
+  {
+    std::ofstream out(path);
+    for (size_t i = 0; i < count; ++i) {
+      out << distribution(generator) << '\n';
+    }
+  }
+  double iostream_write = Seconds(begin);
+
+  generator.seed(42);
+  begin = std::chrono::steady_clock::now();
+  {
+    int fd = open(path.c_str(), O_WRONLY | O_TRUNC);
+    fast_io::Writer out(fd);
+    for (size_t i = 0; i < count; ++i) {
+      out << distribution(generator) << '\n';
+    }
+    out.Flush();
+    close(fd);
+  }
+  double fast_write = Seconds(begin);
+
+  size_t bytes = 0;
+  long long sum = 0;
+  begin = std::chrono::steady_clock::now();
+  {
+    std::ifstream in(path);
+    for (int value; in >> value;) {
+      sum += value;
+    }
+  }
+  double iostream_read = Seconds(begin);
+  long long iostream_sum = sum;
+
+  sum = 0;
+  begin = std::chrono::steady_clock::now();
+  {
+    int fd = open(path.c_str(), O_RDONLY);
+    fast_io::Reader in(fd);
+    for (int value; in >> value;) {
+      sum += value;
+    }
+    bytes = in.BytesRead();
+    close(fd);
+  }
+  double fast_read = Seconds(begin);
+
+  std::printf("%zu integers, %zu bytes\n", count, bytes);
+  Report("std::ofstream <<", bytes, iostream_write, 0);
+  Report("fast_io::Writer <<", bytes, fast_write, 0);
+  Report("std::ifstream >>", bytes, iostream_read, iostream_sum);
+  Report("fast_io::Reader >>", bytes, fast_read, sum);
+  std::remove(path.c_str());
+  return iostream_sum == sum ? 0 : 1;
+}
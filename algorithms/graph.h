@@ -1,8 +1,137 @@
+#pragma once
+
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <cstdint>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
 #include <cassert>
 
-template <typename Vertex>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum storage_type {adjacency_lists, csr, mapped};
+//adjacency_lists: vector for every vertex, edges can be added at any time
+//csr: offsets and one array of all edges, 4 bytes per edge and no allocation per vertex,
+//edges are added to buffer and go to graph by build() or sort_all_adjacency_lists()
+//mapped: csr arrays of binary graph file, file is mapped to memory and is not read or copied
+
+template <typename Function>
+void parallelFor(size_t n, unsigned threads, Function function) {
+	//split [0, n) in equal parts, function(first, last) is called for each part in its own thread
+	threads = std::max(threads, 1u);
+	size_t part_size = (n + threads - 1) / threads;
+	std::vector<std::thread> workers;
+	for (unsigned t = 1; t < threads; ++t) {
+		size_t first = std::min(n, t * part_size);
+		size_t last = std::min(n, first + part_size);
+		workers.emplace_back([&function, first, last] {
+			function(first, last);
+		});
+	}
+	function(0, std::min(n, part_size));
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+inline void makeSortedAdjacency(const std::vector<std::pair<int, int>>& edge_list, int N,
+		std::vector<size_t>& offsets, std::vector<int>& edges, unsigned threads = 1) {
+	//make csr arrays from list of edges {begin, end}:
+	//adjacency lists are sorted, repeated edges and loops are deleted
+	//first digit of key (begin, end) is sorted by counting sort, it gives offsets and lists,
+	//then every list is sorted on its place, it is small and lies in cache
+	//(radix sort by end before counting sort by begin is slower, it is one more random scatter of all edges)
+	//with many threads counters are atomic and lists are divided between threads
+	threads = std::max(threads, 1u);
+	offsets.assign(N+1, 0);
+	if (threads == 1) {
+		for (const std::pair<int, int>& edge : edge_list) {
+			assert(0 <= edge.first && edge.first < N);
+			assert(0 <= edge.second && edge.second < N);
+			if (edge.first != edge.second)
+				++offsets[edge.first+1];
+		}
+		for (int v = 0; v < N; ++v) {
+			offsets[v+1] += offsets[v];
+		}
+		edges.resize(offsets[N]);
+		std::vector<size_t> position(offsets.begin(), offsets.end()-1);
+		for (const std::pair<int, int>& edge : edge_list) {
+			if (edge.first != edge.second)
+				edges[position[edge.first]++] = edge.second;
+		}
+	} else {
+		std::vector<std::atomic<size_t>> position(N);
+		for (int v = 0; v < N; ++v) {
+			position[v].store(0, std::memory_order_relaxed);
+		}
+		parallelFor(edge_list.size(), threads, [&](size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i) {
+				assert(0 <= edge_list[i].first && edge_list[i].first < N);
+				assert(0 <= edge_list[i].second && edge_list[i].second < N);
+				if (edge_list[i].first != edge_list[i].second)
+					position[edge_list[i].first].fetch_add(1, std::memory_order_relaxed);
+			}
+		});
+		for (int v = 0; v < N; ++v) {
+			offsets[v+1] = offsets[v] + position[v].load(std::memory_order_relaxed);
+			position[v].store(offsets[v], std::memory_order_relaxed);
+		}
+		edges.resize(offsets[N]);
+		parallelFor(edge_list.size(), threads, [&](size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i) {
+				if (edge_list[i].first != edge_list[i].second)
+					edges[position[edge_list[i].first].fetch_add(1, std::memory_order_relaxed)] = edge_list[i].second;
+			}
+		});
+	}
+
+	std::vector<size_t> sizes(N+1, 0);
+	//sizes[v+1] is size of list of v without repeated edges, then prefix sum of it
+	parallelFor(N, threads, [&](size_t first, size_t last) {
+		for (size_t v = first; v < last; ++v) {
+			auto begin = edges.begin() + offsets[v];
+			auto end = edges.begin() + offsets[v+1];
+			std::sort(begin, end);
+			sizes[v+1] = std::unique(begin, end) - begin;
+		}
+	});
+	for (int v = 0; v < N; ++v) {
+		sizes[v+1] += sizes[v];
+	}
+
+	if (threads == 1) {
+		//move lists to the left, sizes[v] <= offsets[v]
+		//list which is already on its place is skipped, std::copy must not write to its own source
+		for (int v = 0; v < N; ++v) {
+			if (sizes[v] != offsets[v])
+				std::copy(edges.begin() + offsets[v], edges.begin() + offsets[v] + (sizes[v+1] - sizes[v]),
+						edges.begin() + sizes[v]);
+		}
+		edges.resize(sizes[N]);
+	} else {
+		std::vector<int> new_edges(sizes[N]);
+		parallelFor(N, threads, [&](size_t first, size_t last) {
+			for (size_t v = first; v < last; ++v) {
+				std::copy(edges.begin() + offsets[v], edges.begin() + offsets[v] + (sizes[v+1] - sizes[v]),
+						new_edges.begin() + sizes[v]);
+			}
+		});
+		edges.swap(new_edges);
+	}
+	offsets.swap(sizes);
+}
+
+template <typename Vertex, storage_type storage = adjacency_lists>
 struct Graph {
 	std::vector<std::vector<int>> adjacency_list;
 	//for each vertex remember list of adjacent vertices
@@ -12,14 +141,14 @@ struct Graph {
 	int N;
 	//number of vertices
 
-	Graph(int NN) : N(NN), V(NN), adjacency_list(NN) {
+	Graph(int NN) : adjacency_list(NN), V(NN), N(NN) {
 		//create default vertexes and graph without edges
 		assert(NN > 0);
 	}
-	Graph(std::vector<Vertex>& VV, int NN) : N(NN), V(VV), adjacency_list(NN) {
+	Graph(std::vector<Vertex>& VV, int NN) : adjacency_list(NN), V(VV), N(NN) {
 		//copy vertexes and create graph without edges
 		assert(NN > 0);
-		assert(NN == VV.size());
+		assert(static_cast<size_t>(NN) == VV.size());
 	}
 	~Graph() {}
 
@@ -45,13 +174,208 @@ struct Graph {
 		//create correct order in all adjacency lists
 		for (int i = 0; i < N; ++i) {
 			std::sort(adjacency_list[i].begin(), adjacency_list[i].end());
-			std::unique(adjacency_list[i].begin(), adjacency_list[i].end());
+			adjacency_list[i].erase(std::unique(adjacency_list[i].begin(), adjacency_list[i].end()),
+					adjacency_list[i].end());
 		}
 	}
+
+	void build_from_edges(const std::vector<std::pair<int, int>>& edge_list, unsigned threads = 1) {
+		//replace all edges by edges from list, see makeSortedAdjacency
+		std::vector<size_t> offsets;
+		std::vector<int> edges;
+		makeSortedAdjacency(edge_list, N, offsets, edges, threads);
+		parallelFor(N, threads, [&](size_t first, size_t last) {
+			for (size_t v = first; v < last; ++v) {
+				adjacency_list[v].assign(edges.begin() + offsets[v], edges.begin() + offsets[v+1]);
+			}
+		});
+	}
+
+	const std::vector<int>& neighbours(int v) const {
+		//adjacent vertices of v
+		return adjacency_list[v];
+	}
+};
+
+struct NeighbourRange {
+	//adjacent vertices of one vertex in csr graph
+	const int* first;
+	const int* last;
+
+	const int* begin() const {
+		return first;
+	}
+	const int* end() const {
+		return last;
+	}
+	size_t size() const {
+		return last - first;
+	}
+	bool empty() const {
+		return first == last;
+	}
+	int operator[](size_t i) const {
+		return first[i];
+	}
 };
 
 template <typename Vertex>
-void makeReverseEdges(Graph<Vertex>& graph, Graph<Vertex>& reverse_graph) {
+struct Graph<Vertex, csr> {
+	std::vector<size_t> offsets;
+	//adjacent vertices of v are edges[offsets[v]], ..., edges[offsets[v+1]-1]
+	std::vector<int> edges;
+	//all adjacency lists one after another
+	std::vector<Vertex> V;
+	//vector of vertices
+	int N;
+	//number of vertices
+	std::vector<int> pending_begins;
+	std::vector<int> pending_ends;
+	//edges pushed after last build, they are not in offsets and edges yet
+
+	Graph(int NN) : offsets(NN+1, 0), V(NN), N(NN) {
+		//create default vertexes and graph without edges
+		assert(NN > 0);
+	}
+	Graph(std::vector<Vertex>& VV, int NN) : offsets(NN+1, 0), V(VV), N(NN) {
+		//copy vertexes and create graph without edges
+		assert(NN > 0);
+		assert(static_cast<size_t>(NN) == VV.size());
+	}
+	~Graph() {}
+
+	void reserve_edges(size_t M) {
+		pending_begins.reserve(M);
+		pending_ends.reserve(M);
+	}
+
+	void push_edge_quick_without_correct_order(int begin, int end) {
+		//put edge in buffer, lists must be sorted by sort_all_adjacency_lists
+		assert(0 <= begin && begin < N);
+		assert(0 <= end && end < N);
+		assert(begin != end);
+#ifndef NDEBUG
+		set_last_pending_end(begin, INT_MAX);
+		//order of edges from begin is unknown, push_edge_quick from it can not be checked
+#endif
+		pending_begins.push_back(begin);
+		pending_ends.push_back(end);
+	}
+
+	void push_edge_quick(int begin, int end) {
+		//put edge in buffer, ends of edges from one vertex must be pushed in ascending order
+		//build() keeps this order
+		assert(0 <= begin && begin < N);
+		assert(0 <= end && end < N);
+		assert(begin != end);
+#ifndef NDEBUG
+		assert(is_after_last_edge(begin, end));
+		set_last_pending_end(begin, end);
+#endif
+		pending_begins.push_back(begin);
+		pending_ends.push_back(end);
+	}
+
+	void clear_pending_edges() {
+		//forget edges pushed after last build and free their buffers
+		std::vector<int>().swap(pending_begins);
+		std::vector<int>().swap(pending_ends);
+#ifndef NDEBUG
+		std::vector<int>().swap(last_pending_ends);
+#endif
+	}
+
+	void build() {
+		//put pending edges to graph in two passes:
+		//count degrees and make offsets by prefix sum, then put every edge on its place
+		//old edges of vertex stay before new ones, new ones are in order of pushing
+		if (pending_begins.empty()) {
+			return;
+		}
+		std::vector<size_t> new_offsets(N+1, 0);
+		for (int v = 0; v < N; ++v) {
+			new_offsets[v+1] = offsets[v+1] - offsets[v];
+		}
+		for (int begin : pending_begins) {
+			++new_offsets[begin+1];
+		}
+		for (int v = 0; v < N; ++v) {
+			new_offsets[v+1] += new_offsets[v];
+		}
+
+		std::vector<int> new_edges(new_offsets[N]);
+		std::vector<size_t> position(new_offsets.begin(), new_offsets.end()-1);
+		for (int v = 0; v < N; ++v) {
+			position[v] = std::copy(edges.begin() + offsets[v], edges.begin() + offsets[v+1],
+					new_edges.begin() + position[v]) - new_edges.begin();
+		}
+		for (size_t i = 0; i < pending_begins.size(); ++i) {
+			new_edges[position[pending_begins[i]]++] = pending_ends[i];
+		}
+
+		offsets.swap(new_offsets);
+		edges.swap(new_edges);
+		clear_pending_edges();
+		//free buffer, it is as big as graph
+	}
+
+	void sort_all_adjacency_lists() {
+		//build, then sort all adjacency lists and delete repeated edges
+		build();
+		size_t write = 0;
+		size_t first = offsets[0];
+		for (int v = 0; v < N; ++v) {
+			size_t last = offsets[v+1];
+			std::sort(edges.begin() + first, edges.begin() + last);
+			auto unique_end = std::unique(edges.begin() + first, edges.begin() + last);
+			offsets[v] = write;
+			if (write == first)
+				write = unique_end - edges.begin();
+			else
+				write = std::copy(edges.begin() + first, unique_end, edges.begin() + write) - edges.begin();
+			//write <= first, list is moved to the left only if it is not on its place already
+			first = last;
+		}
+		offsets[N] = write;
+		edges.resize(write);
+	}
+
+	void build_from_edges(const std::vector<std::pair<int, int>>& edge_list, unsigned threads = 1) {
+		//replace all edges by edges from list, see makeSortedAdjacency
+		clear_pending_edges();
+		makeSortedAdjacency(edge_list, N, offsets, edges, threads);
+	}
+
+	NeighbourRange neighbours(int v) const {
+		//adjacent vertices of v, graph must be built
+		assert(pending_begins.empty());
+		return {edges.data() + offsets[v], edges.data() + offsets[v+1]};
+	}
+
+private:
+#ifndef NDEBUG
+	std::vector<int> last_pending_ends;
+	//last end of pending edge for every begin, only for assert in push_edge_quick, empty until it is pushed
+	//INT_MAX after push_edge_quick_without_correct_order from begin
+
+	bool is_after_last_edge(int begin, int end) const {
+		//end is bigger than ends of all edges from begin, built and pending ones
+		int last = last_pending_ends.empty() ? -1 : last_pending_ends[begin];
+		if (last == -1 && offsets[begin] != offsets[begin+1])
+			last = edges[offsets[begin+1]-1];
+		return end > last;
+	}
+
+	void set_last_pending_end(int begin, int end) {
+		if (last_pending_ends.empty())
+			last_pending_ends.assign(N, -1);
+		last_pending_ends[begin] = end;
+	}
+#endif
+};
+
+template <typename Vertex, storage_type storage>
+void makeReverseEdges(const Graph<Vertex, storage>& graph, Graph<Vertex>& reverse_graph) {
 	//delete all edges of second graph
 	//copy all edges of first graph as reverse
 	//adjacency_list order in second graph will correct
@@ -60,8 +384,35 @@ void makeReverseEdges(Graph<Vertex>& graph, Graph<Vertex>& reverse_graph) {
 		reverse_graph.adjacency_list[i].clear();
 	}
 	for (int i = 0; i < graph.N; ++i) {
-		for (int j = 0; j < graph.adjacency_list[i].size(); ++j) {
-			reverse_graph.push_edge_quick(graph.adjacency_list[i][j], i);
+		for (int to : graph.neighbours(i)) {
+			reverse_graph.push_edge_quick(to, i);
+		}
+	}
+}
+
+template <typename Vertex, storage_type storage>
+void makeReverseEdges(const Graph<Vertex, storage>& graph, Graph<Vertex, csr>& reverse_graph) {
+	//delete all edges of second graph, put reverse edges of first graph to it
+	//two passes as in build(): count in-degrees, then put every edge on its place
+	//begins of edges go in ascending order, so adjacency lists of second graph are sorted
+	assert(graph.N == reverse_graph.N);
+	int N = graph.N;
+	reverse_graph.clear_pending_edges();
+	std::vector<size_t>& offsets = reverse_graph.offsets;
+	offsets.assign(N+1, 0);
+	for (int v = 0; v < N; ++v) {
+		for (int to : graph.neighbours(v)) {
+			++offsets[to+1];
+		}
+	}
+	for (int v = 0; v < N; ++v) {
+		offsets[v+1] += offsets[v];
+	}
+	reverse_graph.edges.resize(offsets[N]);
+	std::vector<size_t> position(offsets.begin(), offsets.end()-1);
+	for (int v = 0; v < N; ++v) {
+		for (int to : graph.neighbours(v)) {
+			reverse_graph.edges[position[to]++] = v;
 		}
 	}
 }
@@ -80,6 +431,119 @@ Graph<Vertex>& makeReverseGraphWithCopyV(Graph<Vertex>& graph) {
 	return reverse_graph;
 }
 
+struct GraphFileHeader {
+	//binary graph file: header, then N+1 offsets (uint64_t), then M ends of edges (int32_t)
+	//edges from v are edges[offsets[v]], ..., edges[offsets[v+1]-1], numbers are in native byte order
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+	uint64_t N;
+	uint64_t M;
+};
+
+static const char kGraphFileMagic[8] = {'C', 'S', 'R', 'G', 'R', 'A', 'P', 'H'};
+static const uint32_t kGraphFileVersion = 1;
+
+inline void writeGraphFile(const char* path, int N, const std::vector<size_t>& offsets, const std::vector<int>& edges) {
+	assert(offsets.size() == static_cast<size_t>(N) + 1);
+	assert(offsets[N] == edges.size());
+	GraphFileHeader header = {};
+	std::memcpy(header.magic, kGraphFileMagic, sizeof(header.magic));
+	header.version = kGraphFileVersion;
+	header.N = N;
+	header.M = edges.size();
+
+	FILE* file = std::fopen(path, "wb");
+	if (file == nullptr)
+		throw std::runtime_error(std::string("can not open graph file ") + path);
+	std::vector<uint64_t> file_offsets(offsets.begin(), offsets.end());
+	bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+			std::fwrite(file_offsets.data(), sizeof(uint64_t), file_offsets.size(), file) == file_offsets.size() &&
+			std::fwrite(edges.data(), sizeof(int32_t), edges.size(), file) == edges.size();
+	ok = (std::fclose(file) == 0) && ok;
+	if (!ok)
+		throw std::runtime_error(std::string("can not write graph file ") + path);
+}
+
+template <typename Vertex>
+struct Graph<Vertex, mapped> {
+	const uint64_t* offsets = nullptr;
+	//adjacent vertices of v are edges[offsets[v]], ..., edges[offsets[v+1]-1]
+	const int32_t* edges = nullptr;
+	//both arrays point to mapped file
+	std::vector<Vertex> V;
+	//vector of vertices
+	int N = 0;
+	//number of vertices
+	void* memory = nullptr;
+	size_t memory_size = 0;
+
+	Graph(const char* path, bool verify_edges = false) {
+		//map file, pages are read by OS when traversal touches them
+		//header, size of file and offsets are always checked: offsets start with 0, do not decrease and end with M
+		//ends of edges are checked only with verify_edges, it is one more pass over all edges,
+		//without it file is trusted: end out of [0, N) is undefined behaviour in traversals
+		//bad file: std::runtime_error
+		int fd = open(path, O_RDONLY);
+		if (fd < 0)
+			throw std::runtime_error(std::string("can not open graph file ") + path);
+		struct stat file_stat;
+		if (fstat(fd, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(sizeof(GraphFileHeader))) {
+			close(fd);
+			throw std::runtime_error(std::string("bad graph file ") + path);
+		}
+		memory_size = file_stat.st_size;
+		memory = mmap(nullptr, memory_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (memory == MAP_FAILED) {
+			memory = nullptr;
+			throw std::runtime_error(std::string("can not map graph file ") + path);
+		}
+
+		const GraphFileHeader* header = static_cast<const GraphFileHeader*>(memory);
+		const char* data = static_cast<const char*>(memory) + sizeof(GraphFileHeader);
+		//N is checked before size, (N+1) * 8 can not overflow then,
+		//M * 4 can not overflow if M is not bigger than size of file / 4
+		bool ok = std::memcmp(header->magic, kGraphFileMagic, sizeof(kGraphFileMagic)) == 0 &&
+				header->version == kGraphFileVersion &&
+				header->N > 0 && header->N <= static_cast<uint64_t>(INT32_MAX) &&
+				header->M <= memory_size / sizeof(int32_t) &&
+				memory_size == sizeof(GraphFileHeader) + (header->N + 1) * sizeof(uint64_t) + header->M * sizeof(int32_t);
+		if (ok) {
+			offsets = reinterpret_cast<const uint64_t*>(data);
+			edges = reinterpret_cast<const int32_t*>(data + (header->N + 1) * sizeof(uint64_t));
+			ok = offsets[0] == 0 && offsets[header->N] == header->M;
+			for (uint64_t v = 0; ok && v < header->N; ++v) {
+				ok = offsets[v] <= offsets[v+1];
+			}
+			//offsets[N] == M, so all offsets are not bigger than M
+		}
+		if (ok && verify_edges) {
+			for (uint64_t i = 0; ok && i < header->M; ++i) {
+				ok = 0 <= edges[i] && static_cast<uint64_t>(edges[i]) < header->N;
+			}
+		}
+		if (!ok) {
+			munmap(memory, memory_size);
+			memory = nullptr;
+			throw std::runtime_error(std::string("bad graph file ") + path);
+		}
+		N = header->N;
+		V.resize(N);
+	}
+	Graph(const Graph&) = delete;
+	Graph& operator=(const Graph&) = delete;
+	~Graph() {
+		if (memory != nullptr)
+			munmap(memory, memory_size);
+	}
+
+	NeighbourRange neighbours(int v) const {
+		//adjacent vertices of v
+		return {edges + offsets[v], edges + offsets[v+1]};
+	}
+};
+
 enum color_type {white, grey, black};
 
 struct DFSVertex {
@@ -91,15 +555,1051 @@ struct DFSVertex {
 
 int timer = 0;
 
-void DFS(Graph<DFSVertex>& graph, int v, int p = -1) {
-	graph.V[v].parent = p;
-	graph.V[v].tin = timer++;
-	graph.V[v].color = grey;
-	for (int to: graph.adjacency_list[v]) {
-		if (graph.V[to].color != white)
+struct DFSNoAction {
+	//default callback of DFS, does nothing and lets DFS go on
+	template <typename... Args>
+	bool operator()(Args...) const {
+		return true;
+	}
+};
+
+enum dfs_property {record_parent = 1, record_tin = 2, record_tout = 4, record_all = 7};
+//properties of vertices which DFSState keeps, they can be combined by |
+
+template <unsigned properties = 0>
+struct DFSState {
+	//state of traversal as structure of arrays instead of DFSVertex in Graph::V
+	//color takes 2 bits, 32 vertices in one word, so traversal which needs only color
+	//reads 64 times less memory than with 16 bytes of DFSVertex
+	//parent, tin and tout have own arrays, they are allocated only if they are in properties
+	std::vector<uint64_t> colors;
+	std::vector<int> parent;
+	std::vector<int> tin;
+	std::vector<int> tout;
+	int timer = 0;
+	int N;
+	//number of vertices
+
+	DFSState(int NN) : colors((static_cast<size_t>(NN) + 31) / 32, 0), N(NN) {
+		//all vertices are white
+		if (properties & record_parent)
+			parent.assign(NN, -1);
+		if (properties & record_tin)
+			tin.assign(NN, -1);
+		if (properties & record_tout)
+			tout.assign(NN, -1);
+	}
+
+	color_type color(int v) const {
+		return static_cast<color_type>((colors[v / 32] >> (v % 32 * 2)) & 3);
+	}
+
+	void set_color(int v, color_type color) {
+		int shift = v % 32 * 2;
+		colors[v / 32] = (colors[v / 32] & ~(uint64_t(3) << shift)) | (uint64_t(color) << shift);
+	}
+
+	void enter(int v, int p) {
+		//v becomes grey
+		if (properties & record_parent)
+			parent[v] = p;
+		if (properties & record_tin)
+			tin[v] = timer;
+		++timer;
+		set_color(v, grey);
+	}
+
+	void exit(int v) {
+		//v becomes black
+		if (properties & record_tout)
+			tout[v] = timer;
+		++timer;
+		set_color(v, black);
+	}
+};
+
+struct DFSVertexState {
+	//state of traversal in DFSVertex of Graph::V with global timer
+	std::vector<DFSVertex>& V;
+
+	color_type color(int v) const {
+		return V[v].color;
+	}
+
+	void enter(int v, int p) {
+		V[v].parent = p;
+		V[v].tin = timer++;
+		V[v].color = grey;
+	}
+
+	void exit(int v) {
+		V[v].tout = timer++;
+		V[v].color = black;
+	}
+};
+
+template <typename GraphType, typename State, typename OnEnter, typename OnExit, typename OnEdge>
+bool depthFirstSearch(const GraphType& graph, State& state, int v, int p,
+		OnEnter& on_enter, OnExit& on_exit, OnEdge& on_edge) {
+	//DFS without recursion: stack of vertices with position in their adjacency lists
+	//state keeps colors and records what it needs in enter and exit, see DFSState and DFSVertexState
+	struct Frame {
+		int v;
+		size_t cursor;
+	};
+	std::vector<Frame> stack;
+
+	auto enter = [&](int u, int parent) {
+		state.enter(u, parent);
+		on_enter(u);
+		stack.push_back({u, 0});
+	};
+
+	enter(v, p);
+	while (!stack.empty()) {
+		int u = stack.back().v;
+		auto&& adjacent = graph.neighbours(u);
+		size_t& cursor = stack.back().cursor;
+		if (cursor < adjacent.size()) {
+			int to = adjacent[cursor++];
+			if (!on_edge(u, to))
+				return false;
+			if (state.color(to) == white)
+				enter(to, u);
+		} else {
+			state.exit(u);
+			on_exit(u);
+			stack.pop_back();
+		}
+	}
+	return true;
+}
+
+template <storage_type storage, typename OnEnter = DFSNoAction, typename OnExit = DFSNoAction,
+		typename OnEdge = DFSNoAction>
+bool DFS(Graph<DFSVertex, storage>& graph, int v, int p = -1,
+		OnEnter on_enter = OnEnter(), OnExit on_exit = OnExit(), OnEdge on_edge = OnEdge()) {
+	//DFS without recursion, so it works on very deep graphs
+	//tin, tout, parent and color in graph.V are the same as in recursive DFS
+	//on_enter(v) is called when v becomes grey, on_exit(v) when v becomes black
+	//on_edge(v, to) is called for every edge before going to to, if it returns false DFS stops
+	//return: false if DFS was stopped by on_edge
+	DFSVertexState state{graph.V};
+	return depthFirstSearch(graph, state, v, p, on_enter, on_exit, on_edge);
+}
+
+template <unsigned properties, typename Vertex, storage_type storage, typename OnEnter = DFSNoAction,
+		typename OnExit = DFSNoAction, typename OnEdge = DFSNoAction>
+bool DFS(const Graph<Vertex, storage>& graph, DFSState<properties>& state, int v, int p = -1,
+		OnEnter on_enter = OnEnter(), OnExit on_exit = OnExit(), OnEdge on_edge = OnEdge()) {
+	//the same DFS with state out of graph, only properties of state are recorded
+	//graph.V is not used, so graph can have any Vertex
+	return depthFirstSearch(graph, state, v, p, on_enter, on_exit, on_edge);
+}
+
+struct TopologicalOrder {
+	std::vector<int> order;
+	//vertices level by level, vertices of one level in ascending order
+	std::vector<int> level;
+	//level[v] is length of the longest path which ends in v
+	//vertices of one level do not depend on each other and can be processed together
+	std::vector<int> level_begin;
+	//vertices of level l are order[level_begin[l]], ..., order[level_begin[l+1]-1]
+	std::vector<int> cycle;
+	//empty if graph is acyclic
+	//else vertices of some cycle: edges go from cycle[i] to cycle[i+1] and from last vertex to first
+	//order, level and level_begin are empty then
+
+	bool is_acyclic() const {
+		return cycle.empty();
+	}
+};
+
+template <typename Vertex, storage_type storage>
+std::vector<int> findCycle(const Graph<Vertex, storage>& graph, const std::vector<int>& level) {
+	//find cycle among vertices with level -1, they must have cycle
+	//DFS without recursion, edge to grey vertex closes cycle which is on the stack
+	DFSState<> state(graph.N);
+	//only colors are needed, 2 bits per vertex
+	std::vector<std::pair<int, size_t>> stack;
+	for (int root = 0; root < graph.N; ++root) {
+		if (level[root] != -1 || state.color(root) != white)
 			continue;
-		DFS(graph, to, v);
+		state.set_color(root, grey);
+		stack.push_back({root, 0});
+		while (!stack.empty()) {
+			int u = stack.back().first;
+			auto&& adjacent = graph.neighbours(u);
+			size_t& cursor = stack.back().second;
+			if (cursor == adjacent.size()) {
+				state.set_color(u, black);
+				stack.pop_back();
+				continue;
+			}
+			int to = adjacent[cursor++];
+			if (level[to] != -1 || state.color(to) == black)
+				continue;
+			if (state.color(to) == grey) {
+				size_t first = stack.size() - 1;
+				while (stack[first].first != to) {
+					--first;
+				}
+				std::vector<int> cycle;
+				for (size_t i = first; i < stack.size(); ++i) {
+					cycle.push_back(stack[i].first);
+				}
+				return cycle;
+			}
+			state.set_color(to, grey);
+			stack.push_back({to, 0});
+		}
+	}
+	return {};
+}
+
+static const size_t kParallelFrontier = 1 << 14;
+//smaller frontiers are processed by one thread, starting threads costs more
+
+template <typename Vertex, storage_type storage>
+TopologicalOrder topologicalSort(const Graph<Vertex, storage>& graph,
+		unsigned threads = std::thread::hardware_concurrency()) {
+	//Kahn algorithm level by level:
+	//frontier is vertices without incoming edges, removing its edges makes next frontier
+	//big frontier is split between threads, in-degrees are atomic,
+	//vertex goes to next frontier of thread which removed its last incoming edge
+	//order is made by counting sort by level, O(N + M) without comparison sort
+	int N = graph.N;
+	threads = std::max(threads, 1u);
+
+	std::vector<std::atomic<int>> in_degree(N);
+	for (int v = 0; v < N; ++v) {
+		in_degree[v].store(0, std::memory_order_relaxed);
+	}
+	for (int v = 0; v < N; ++v) {
+		for (int to : graph.neighbours(v)) {
+			in_degree[to].fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	TopologicalOrder answer;
+	answer.level.assign(N, -1);
+	std::vector<int> frontier;
+	for (int v = 0; v < N; ++v) {
+		if (in_degree[v].load(std::memory_order_relaxed) == 0)
+			frontier.push_back(v);
 	}
-	graph.V[v].tout = timer++;
-	graph.V[v].color = black;
+
+	std::vector<std::vector<int>> next(threads);
+	auto relax = [&graph, &in_degree, &frontier](size_t first, size_t last, std::vector<int>& found) {
+		for (size_t i = first; i < last; ++i) {
+			for (int to : graph.neighbours(frontier[i])) {
+				if (in_degree[to].fetch_sub(1, std::memory_order_relaxed) == 1)
+					found.push_back(to);
+			}
+		}
+	};
+
+	int levels = 0;
+	int processed = 0;
+	while (!frontier.empty()) {
+		for (int v : frontier) {
+			answer.level[v] = levels;
+		}
+		processed += frontier.size();
+		++levels;
+
+		size_t parts = (frontier.size() < kParallelFrontier) ? 1 : threads;
+		size_t part_size = (frontier.size() + parts - 1) / parts;
+		std::vector<std::thread> workers;
+		for (size_t t = 1; t < parts; ++t) {
+			size_t first = std::min(frontier.size(), t * part_size);
+			size_t last = std::min(frontier.size(), first + part_size);
+			workers.emplace_back([&relax, &next, first, last, t] {
+				relax(first, last, next[t]);
+			});
+		}
+		relax(0, std::min(frontier.size(), part_size), next[0]);
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+
+		frontier.clear();
+		for (size_t t = 0; t < parts; ++t) {
+			frontier.insert(frontier.end(), next[t].begin(), next[t].end());
+			next[t].clear();
+		}
+	}
+
+	if (processed < N) {
+		answer.cycle = findCycle(graph, answer.level);
+		answer.level.clear();
+		return answer;
+	}
+
+	answer.level_begin.assign(levels + 1, 0);
+	for (int v = 0; v < N; ++v) {
+		++answer.level_begin[answer.level[v] + 1];
+	}
+	for (int l = 0; l < levels; ++l) {
+		answer.level_begin[l+1] += answer.level_begin[l];
+	}
+	answer.order.resize(N);
+	std::vector<int> position(answer.level_begin.begin(), answer.level_begin.end() - 1);
+	for (int v = 0; v < N; ++v) {
+		answer.order[position[answer.level[v]]++] = v;
+	}
+	return answer;
+}
+
+struct BFSResult {
+	std::vector<int> distance;
+	//distance[v] is number of edges in shortest path from source to v, -1 if v is not reachable
+	std::vector<int> parent;
+	//previous vertex of v in some shortest path, -1 for source and not reachable vertices
+	//with many threads it can be different from run to run, distance is always the same
+
+	bool is_reachable(int v) const {
+		return distance[v] != -1;
+	}
+};
+
+static const size_t kBFSTopDownFactor = 14;
+//go bottom-up when edges of frontier are more than unexplored edges / kBFSTopDownFactor
+static const size_t kBFSBottomUpFactor = 24;
+//go back top-down when frontier becomes smaller and less than N / kBFSBottomUpFactor
+
+template <typename Vertex, storage_type storage, storage_type reverse_storage>
+BFSResult directionOptimizingBFS(const Graph<Vertex, storage>& graph,
+		const Graph<Vertex, reverse_storage>* reverse_graph, int source, unsigned threads) {
+	//BFS level by level (Beamer, Asanovic, Patterson), two kinds of step:
+	//top-down: every vertex of frontier looks at its edges and takes not visited ends,
+	//it is good while frontier is small
+	//bottom-up: every not visited vertex looks at its incoming edges for a vertex of frontier
+	//and stops at first found, it is good when frontier is big and most edges would hit visited vertices
+	//visited is a bitset: top-down takes vertex by atomic fetch_or, only one thread gets it;
+	//bottom-up splits vertices by words of bitset, so every word is written by one thread
+	//frontier is a queue for top-down and a bitset for bottom-up,
+	//threads collect found vertices in own buffers and copy them to next queue at once
+	//without reverse_graph only top-down steps are made
+	int N = graph.N;
+	assert(0 <= source && source < N);
+	assert(reverse_graph == nullptr || reverse_graph->N == N);
+	threads = std::max(threads, 1u);
+	const size_t words = (static_cast<size_t>(N) + 63) / 64;
+	auto parts = [threads](size_t n) {
+		return n < kParallelFrontier ? 1u : threads;
+	};
+
+	BFSResult answer;
+	answer.distance.assign(N, -1);
+	answer.parent.assign(N, -1);
+
+	std::vector<std::atomic<uint64_t>> visited(words);
+	for (size_t w = 0; w < words; ++w) {
+		visited[w].store(0, std::memory_order_relaxed);
+	}
+	if (N % 64 != 0) {
+		//bits after last vertex are visited, bottom-up skips full words
+		visited[words-1].store(~uint64_t(0) << (N % 64), std::memory_order_relaxed);
+	}
+
+	std::atomic<size_t> total_edges(0);
+	parallelFor(N, parts(N), [&graph, &total_edges](size_t first, size_t last) {
+		size_t local = 0;
+		for (size_t v = first; v < last; ++v) {
+			local += graph.neighbours(v).size();
+		}
+		total_edges.fetch_add(local, std::memory_order_relaxed);
+	});
+	size_t edges_to_check = total_edges.load();
+	//edges of not visited vertices, estimated as in the paper: all edges minus edges of top-down frontiers
+
+	std::vector<int> queue(N);
+	std::vector<int> next_queue(N);
+	size_t queue_size = 1;
+	queue[0] = source;
+	answer.distance[source] = 0;
+	visited[source / 64].fetch_or(uint64_t(1) << (source % 64), std::memory_order_relaxed);
+	size_t scout_count = graph.neighbours(source).size();
+	//edges of frontier
+	std::vector<uint64_t> front;
+	std::vector<uint64_t> next_front;
+	int level = 0;
+
+	auto top_down_step = [&]() {
+		std::atomic<size_t> next_size(0);
+		std::atomic<size_t> next_scout(0);
+		parallelFor(queue_size, parts(queue_size), [&](size_t first, size_t last) {
+			std::vector<int> found;
+			size_t local_scout = 0;
+			for (size_t i = first; i < last; ++i) {
+				int u = queue[i];
+				for (int to : graph.neighbours(u)) {
+					uint64_t bit = uint64_t(1) << (to % 64);
+					if ((visited[to / 64].load(std::memory_order_relaxed) & bit) != 0)
+						continue;
+					if ((visited[to / 64].fetch_or(bit, std::memory_order_relaxed) & bit) != 0)
+						continue;
+					answer.distance[to] = level + 1;
+					answer.parent[to] = u;
+					found.push_back(to);
+					local_scout += graph.neighbours(to).size();
+				}
+			}
+			size_t at = next_size.fetch_add(found.size(), std::memory_order_relaxed);
+			std::copy(found.begin(), found.end(), next_queue.begin() + at);
+			next_scout.fetch_add(local_scout, std::memory_order_relaxed);
+		});
+		queue.swap(next_queue);
+		queue_size = next_size.load();
+		return next_scout.load();
+	};
+
+	auto bottom_up_step = [&]() {
+		std::atomic<size_t> awake(0);
+		parallelFor(words, parts(N), [&](size_t first, size_t last) {
+			size_t local_awake = 0;
+			for (size_t w = first; w < last; ++w) {
+				uint64_t seen = visited[w].load(std::memory_order_relaxed);
+				uint64_t found = 0;
+				if (~seen == 0) {
+					next_front[w] = 0;
+					continue;
+				}
+				for (int b = 0; b < 64; ++b) {
+					if ((seen >> b) & 1)
+						continue;
+					int v = w * 64 + b;
+					for (int u : reverse_graph->neighbours(v)) {
+						if ((front[u / 64] >> (u % 64)) & 1) {
+							answer.distance[v] = level + 1;
+							answer.parent[v] = u;
+							found |= uint64_t(1) << b;
+							++local_awake;
+							break;
+						}
+					}
+				}
+				next_front[w] = found;
+				if (found != 0)
+					visited[w].store(seen | found, std::memory_order_relaxed);
+			}
+			awake.fetch_add(local_awake, std::memory_order_relaxed);
+		});
+		front.swap(next_front);
+		return awake.load();
+	};
+
+	while (queue_size > 0) {
+		if (reverse_graph != nullptr && scout_count > edges_to_check / kBFSTopDownFactor) {
+			front.assign(words, 0);
+			next_front.assign(words, 0);
+			for (size_t i = 0; i < queue_size; ++i) {
+				front[queue[i] / 64] |= uint64_t(1) << (queue[i] % 64);
+			}
+			size_t awake_count = queue_size;
+			size_t old_awake_count;
+			do {
+				old_awake_count = awake_count;
+				awake_count = bottom_up_step();
+				++level;
+			} while (awake_count > 0 &&
+					(awake_count >= old_awake_count || awake_count > N / kBFSBottomUpFactor));
+
+			//frontier bitset to queue
+			std::atomic<size_t> next_size(0);
+			parallelFor(words, parts(N), [&](size_t first, size_t last) {
+				std::vector<int> found;
+				for (size_t w = first; w < last; ++w) {
+					for (int b = 0; b < 64 && (front[w] >> b) != 0; ++b) {
+						if ((front[w] >> b) & 1)
+							found.push_back(w * 64 + b);
+					}
+				}
+				size_t at = next_size.fetch_add(found.size(), std::memory_order_relaxed);
+				std::copy(found.begin(), found.end(), queue.begin() + at);
+			});
+			queue_size = next_size.load();
+			scout_count = 1;
+		} else {
+			edges_to_check -= std::min(scout_count, edges_to_check);
+			scout_count = top_down_step();
+			++level;
+		}
+	}
+	return answer;
+}
+
+template <typename Vertex, storage_type storage, storage_type reverse_storage>
+BFSResult BFS(const Graph<Vertex, storage>& graph, const Graph<Vertex, reverse_storage>& reverse_graph,
+		int source, unsigned threads = std::thread::hardware_concurrency()) {
+	//direction-optimizing parallel BFS, reverse_graph has reverse edges of graph, see makeReverseEdges
+	return directionOptimizingBFS(graph, &reverse_graph, source, threads);
+}
+
+template <typename Vertex, storage_type storage>
+BFSResult BFS(const Graph<Vertex, storage>& graph, int source,
+		unsigned threads = std::thread::hardware_concurrency()) {
+	//parallel BFS with top-down steps only, it does not need incoming edges
+	return directionOptimizingBFS(graph, static_cast<const Graph<Vertex, storage>*>(nullptr), source, threads);
+}
+
+struct StronglyConnectedComponents {
+	std::vector<int> component;
+	//component[v] is id of strongly connected component of v, ids are 0, ..., count-1
+	int count = 0;
+	//number of components
+};
+
+template <typename Vertex, storage_type storage>
+int tarjanComponents(const Graph<Vertex, storage>& graph, std::vector<int>& component, int count) {
+	//Tarjan algorithm without recursion for vertices with component -1, other vertices and their edges are ignored
+	//stack of calls keeps vertex and position in its adjacency list, so it works on very deep graphs
+	//found components get ids count, count+1, ... in topological order:
+	//edge from one new component to another goes from smaller id to bigger
+	//return: count of all components
+	int N = graph.N;
+	std::vector<int> index(N, -1);
+	//order of entering, -1 if vertex was not visited
+	std::vector<int> low(N);
+	std::vector<int> stack;
+	//visited vertices without component
+	std::vector<std::pair<int, size_t>> calls;
+	int next_index = 0;
+	int first_id = count;
+
+	auto enter = [&](int u) {
+		index[u] = low[u] = next_index++;
+		stack.push_back(u);
+		calls.push_back({u, 0});
+	};
+
+	for (int root = 0; root < N; ++root) {
+		if (component[root] != -1 || index[root] != -1)
+			continue;
+		enter(root);
+		while (!calls.empty()) {
+			int u = calls.back().first;
+			auto&& adjacent = graph.neighbours(u);
+			size_t& cursor = calls.back().second;
+			if (cursor < adjacent.size()) {
+				int to = adjacent[cursor++];
+				if (component[to] != -1)
+					continue;
+				//vertex of finished component
+				if (index[to] == -1)
+					enter(to);
+				else
+					low[u] = std::min(low[u], index[to]);
+				continue;
+			}
+			calls.pop_back();
+			if (!calls.empty()) {
+				int parent = calls.back().first;
+				low[parent] = std::min(low[parent], low[u]);
+			}
+			if (low[u] == index[u]) {
+				int w;
+				do {
+					w = stack.back();
+					stack.pop_back();
+					component[w] = count;
+				} while (w != u);
+				++count;
+			}
+		}
+	}
+
+	//Tarjan finds components in reverse topological order
+	for (int v = 0; v < N; ++v) {
+		if (index[v] != -1)
+			component[v] = count - 1 - (component[v] - first_id);
+	}
+	return count;
+}
+
+template <typename Vertex, storage_type storage>
+StronglyConnectedComponents stronglyConnectedComponents(const Graph<Vertex, storage>& graph) {
+	//ids of components are in topological order of condensation, see tarjanComponents
+	StronglyConnectedComponents answer;
+	answer.component.assign(graph.N, -1);
+	answer.count = tarjanComponents(graph, answer.component, 0);
+	return answer;
+}
+
+template <typename Vertex, storage_type storage, storage_type reverse_storage>
+StronglyConnectedComponents parallelStronglyConnectedComponents(const Graph<Vertex, storage>& graph,
+		const Graph<Vertex, reverse_storage>& reverse_graph, unsigned threads = std::thread::hardware_concurrency()) {
+	//trimming and FW-BW (Fleischer, Hendrickson, Pinar; Hong, Rodia, Olukotun):
+	//1. trim: vertex without live incoming or outgoing edges is a component of its own,
+	//   rounds are repeated while they remove many vertices
+	//2. FW-BW: vertices reachable from pivot and vertices from which pivot is reachable are found by
+	//   parallel BFS on graph and reverse_graph, their intersection is component of pivot.
+	//   pivot is vertex with biggest in-degree * out-degree, so first component is usually the giant one
+	//3. when components become small, the rest is done by tarjanComponents
+	//ids of components are not in topological order, reverse_graph has reverse edges of graph
+	int N = graph.N;
+	assert(reverse_graph.N == N);
+	threads = std::max(threads, 1u);
+	auto parts = [threads](size_t n) {
+		return n < kParallelFrontier ? 1u : threads;
+	};
+
+	StronglyConnectedComponents answer;
+	std::vector<int>& component = answer.component;
+	component.assign(N, -1);
+	std::atomic<int> count(0);
+
+	auto trim = [&]() {
+		std::vector<char> trimmed(N, 0);
+		std::atomic<size_t> removed(0);
+		do {
+			removed.store(0);
+			parallelFor(N, parts(N), [&](size_t first, size_t last) {
+				size_t local = 0;
+				for (size_t v = first; v < last; ++v) {
+					if (component[v] != -1)
+						continue;
+					auto live = [&component, v](int u) {
+						return component[u] == -1 && u != static_cast<int>(v);
+					};
+					auto&& out = graph.neighbours(v);
+					auto&& in = reverse_graph.neighbours(v);
+					if (std::none_of(out.begin(), out.end(), live) || std::none_of(in.begin(), in.end(), live)) {
+						trimmed[v] = 1;
+						++local;
+					}
+				}
+				removed.fetch_add(local, std::memory_order_relaxed);
+			});
+			//components are given after the round, so all threads see the same live vertices
+			parallelFor(N, parts(N), [&](size_t first, size_t last) {
+				for (size_t v = first; v < last; ++v) {
+					if (trimmed[v]) {
+						trimmed[v] = 0;
+						component[v] = count.fetch_add(1, std::memory_order_relaxed);
+					}
+				}
+			});
+		} while (removed.load() >= kParallelFrontier);
+	};
+
+	std::vector<std::atomic<uint8_t>> mark(N);
+	for (int v = 0; v < N; ++v) {
+		mark[v].store(0, std::memory_order_relaxed);
+	}
+	std::vector<int> frontier(N);
+	std::vector<int> next(N);
+	auto reach = [&](const auto& g, int pivot, uint8_t flag) {
+		//put flag to all live vertices reachable from pivot in g
+		mark[pivot].fetch_or(flag, std::memory_order_relaxed);
+		frontier[0] = pivot;
+		size_t frontier_size = 1;
+		while (frontier_size > 0) {
+			std::atomic<size_t> next_size(0);
+			parallelFor(frontier_size, parts(frontier_size), [&](size_t first, size_t last) {
+				std::vector<int> found;
+				for (size_t i = first; i < last; ++i) {
+					for (int to : g.neighbours(frontier[i])) {
+						if (component[to] != -1 || (mark[to].load(std::memory_order_relaxed) & flag) != 0)
+							continue;
+						if ((mark[to].fetch_or(flag, std::memory_order_relaxed) & flag) == 0)
+							found.push_back(to);
+					}
+				}
+				size_t at = next_size.fetch_add(found.size(), std::memory_order_relaxed);
+				std::copy(found.begin(), found.end(), next.begin() + at);
+			});
+			frontier.swap(next);
+			frontier_size = next_size.load();
+		}
+	};
+
+	while (true) {
+		trim();
+		int pivot = -1;
+		size_t best = 0;
+		for (int v = 0; v < N; ++v) {
+			size_t weight = graph.neighbours(v).size() * reverse_graph.neighbours(v).size();
+			if (component[v] == -1 && (pivot == -1 || weight > best)) {
+				pivot = v;
+				best = weight;
+			}
+		}
+		if (pivot == -1)
+			break;
+
+		reach(graph, pivot, 1);
+		reach(reverse_graph, pivot, 2);
+		int id = count.fetch_add(1);
+		std::atomic<size_t> size(0);
+		parallelFor(N, parts(N), [&](size_t first, size_t last) {
+			size_t local = 0;
+			for (size_t v = first; v < last; ++v) {
+				if (mark[v].load(std::memory_order_relaxed) == 3) {
+					component[v] = id;
+					++local;
+				}
+				mark[v].store(0, std::memory_order_relaxed);
+			}
+			size.fetch_add(local, std::memory_order_relaxed);
+		});
+		if (size.load() < kParallelFrontier)
+			break;
+	}
+
+	answer.count = tarjanComponents(graph, component, count.load());
+	return answer;
+}
+
+template <typename Vertex, storage_type storage, typename CondensationVertex>
+void makeCondensation(const Graph<Vertex, storage>& graph, const StronglyConnectedComponents& components,
+		Graph<CondensationVertex, csr>& condensation, unsigned threads = 1) {
+	//delete all edges of second graph and make it condensation of first graph:
+	//vertex is component, edge goes from a to b if some edge goes from component a to component b
+	//condensation is acyclic, edges inside components and repeated edges are deleted by build_from_edges
+	assert(condensation.N == components.count);
+	std::vector<std::pair<int, int>> edge_list;
+	for (int v = 0; v < graph.N; ++v) {
+		for (int to : graph.neighbours(v)) {
+			if (components.component[v] != components.component[to])
+				edge_list.push_back({components.component[v], components.component[to]});
+		}
+	}
+	condensation.build_from_edges(edge_list, threads);
+}
+
+static const size_t kDynamicOrderBatchFactor = 16;
+//batch of edges with size more than (N + M) / kDynamicOrderBatchFactor is sorted again by topologicalSort
+
+template <typename Vertex>
+struct DynamicTopologicalOrder {
+	//topological order of graph which gets new edges (Pearce, Kelly):
+	//edge begin -> end with begin before end does not change order,
+	//else only vertices between end and begin in order can move:
+	//forward search from end and backward search from begin go only through this part of order,
+	//found vertices take the same positions, first vertices which reach begin, then vertices reachable from end
+	//cost of insertion depends on this part and its edges, not on size of graph
+	Graph<Vertex> graph;
+	Graph<Vertex> reverse_graph;
+	//edges and reverse edges, adjacency lists are in order of insertion
+	std::vector<int> order;
+	//vertices in topological order
+	std::vector<int> position;
+	//order[position[v]] == v
+	int N;
+	//number of vertices
+	size_t M = 0;
+	//number of edges
+	std::vector<char> visited;
+	//marks of searches, all zero between insertions
+	std::vector<int> stack, forward, backward, positions;
+	//buffers of searches, they are kept to not allocate memory on every insertion
+	std::vector<std::pair<int, int>> moved;
+	//vertices moved by insert_edges and their previous positions, to restore order if batch makes cycle
+
+	DynamicTopologicalOrder(int NN) : graph(NN), reverse_graph(NN), order(NN), position(NN), N(NN), visited(NN, 0) {
+		//graph without edges, any order is topological
+		for (int v = 0; v < N; ++v) {
+			order[v] = position[v] = v;
+		}
+	}
+
+	template <storage_type storage>
+	DynamicTopologicalOrder(const Graph<Vertex, storage>& initial_graph) : DynamicTopologicalOrder(initial_graph.N) {
+		//copy edges of graph, throw std::invalid_argument if it has cycle
+		for (int v = 0; v < N; ++v) {
+			for (int to : initial_graph.neighbours(v)) {
+				if (v == to)
+					throw std::invalid_argument("graph has a cycle");
+				push_edge(v, to);
+			}
+		}
+		if (!sort_again())
+			throw std::invalid_argument("graph has a cycle");
+	}
+
+	bool precedes(int a, int b) const {
+		//true if a is before b in order
+		return position[a] < position[b];
+	}
+
+	bool insert_edge(int begin, int end) {
+		//add edge and keep order topological
+		//return: false if edge makes cycle, then it is not added
+		assert(0 <= begin && begin < N);
+		assert(0 <= end && end < N);
+		if (begin == end)
+			return false;
+		if (position[end] < position[begin] && !reorder(begin, end, false))
+			return false;
+		push_edge(begin, end);
+		return true;
+	}
+
+	bool insert_edges(const std::vector<std::pair<int, int>>& edge_list) {
+		//add all edges or none of them
+		//return: false if edges make cycle, then graph and order are not changed
+		//big batch is added at once and whole order is made by topologicalSort,
+		//small one is added edge by edge, if some edge makes cycle added edges are deleted
+		//and moved vertices get back their positions
+		if (edge_list.size() * kDynamicOrderBatchFactor >= N + M) {
+			for (const std::pair<int, int>& edge : edge_list) {
+				if (edge.first == edge.second)
+					return false;
+			}
+			for (const std::pair<int, int>& edge : edge_list) {
+				push_edge(edge.first, edge.second);
+			}
+			if (sort_again())
+				return true;
+			pop_edges(edge_list, edge_list.size());
+			return false;
+		}
+		moved.clear();
+		for (size_t i = 0; i < edge_list.size(); ++i) {
+			int begin = edge_list[i].first;
+			int end = edge_list[i].second;
+			assert(0 <= begin && begin < N);
+			assert(0 <= end && end < N);
+			if (begin == end || (position[end] < position[begin] && !reorder(begin, end, true))) {
+				pop_edges(edge_list, i);
+				for (size_t j = moved.size(); j-- > 0;) {
+					position[moved[j].first] = moved[j].second;
+					order[moved[j].second] = moved[j].first;
+				}
+				//reorders are undone from the last one, every one of them permutes its own positions
+				return false;
+			}
+			push_edge(begin, end);
+		}
+		return true;
+	}
+
+private:
+	void push_edge(int begin, int end) {
+		graph.push_edge_quick_without_correct_order(begin, end);
+		reverse_graph.push_edge_quick_without_correct_order(end, begin);
+		++M;
+	}
+
+	void pop_edges(const std::vector<std::pair<int, int>>& edge_list, size_t count) {
+		//delete first count edges of list, they are the last pushed ones
+		for (size_t i = count; i-- > 0;) {
+			graph.adjacency_list[edge_list[i].first].pop_back();
+			reverse_graph.adjacency_list[edge_list[i].second].pop_back();
+			--M;
+		}
+	}
+
+	bool sort_again() {
+		//make whole order by topologicalSort, return false if graph has cycle
+		TopologicalOrder topological_order = topologicalSort(graph);
+		if (!topological_order.is_acyclic())
+			return false;
+		order.swap(topological_order.order);
+		for (int i = 0; i < N; ++i) {
+			position[order[i]] = i;
+		}
+		return true;
+	}
+
+	template <typename InRange>
+	bool search(const Graph<Vertex>& g, int start, int target, InRange in_range, std::vector<int>& found) {
+		//DFS from start through vertices with positions in range, found gets all visited vertices
+		//return: false if target is reached
+		visited[start] = 1;
+		found.push_back(start);
+		stack.push_back(start);
+		while (!stack.empty()) {
+			int u = stack.back();
+			stack.pop_back();
+			for (int to : g.neighbours(u)) {
+				if (to == target) {
+					stack.clear();
+					return false;
+				}
+				if (!visited[to] && in_range(position[to])) {
+					visited[to] = 1;
+					found.push_back(to);
+					stack.push_back(to);
+				}
+			}
+		}
+		return true;
+	}
+
+	bool reorder(int begin, int end, bool save_moved) {
+		//position[end] < position[begin], move vertices between them for edge begin -> end
+		//save_moved: append found vertices with their old positions to moved
+		int lower = position[end];
+		int upper = position[begin];
+		forward.clear();
+		backward.clear();
+		bool acyclic = search(graph, end, begin, [upper](int p) {
+			return p < upper;
+		}, forward);
+		if (acyclic) {
+			search(reverse_graph, begin, -1, [lower](int p) {
+				return p > lower;
+			}, backward);
+		}
+		for (int v : forward) {
+			visited[v] = 0;
+		}
+		for (int v : backward) {
+			visited[v] = 0;
+		}
+		if (!acyclic)
+			return false;
+
+		auto by_position = [this](int a, int b) {
+			return position[a] < position[b];
+		};
+		std::sort(forward.begin(), forward.end(), by_position);
+		std::sort(backward.begin(), backward.end(), by_position);
+		positions.clear();
+		for (int v : backward) {
+			positions.push_back(position[v]);
+		}
+		for (int v : forward) {
+			positions.push_back(position[v]);
+		}
+		std::inplace_merge(positions.begin(), positions.begin() + backward.size(), positions.end());
+		if (save_moved) {
+			for (int v : backward) {
+				moved.push_back({v, position[v]});
+			}
+			for (int v : forward) {
+				moved.push_back({v, position[v]});
+			}
+		}
+		size_t i = 0;
+		for (int v : backward) {
+			position[v] = positions[i];
+			order[positions[i++]] = v;
+		}
+		for (int v : forward) {
+			position[v] = positions[i];
+			order[positions[i++]] = v;
+		}
+		return true;
+	}
+};
+
+enum reorder_type {bfs_order, reverse_cuthill_mckee, degree_order};
+//bfs_order: vertices in order of BFS from vertex 0, other components from their smallest vertex
+//reverse_cuthill_mckee: BFS from vertex of minimal degree, neighbours by ascending degree, then reversed,
+//it keeps neighbours close in numbering on meshes and road networks
+//degree_order: vertices by descending degree, adjacency lists of big vertices are together
+//searches go by edges of graph, for undirected graph both directions of edge must be in it
+
+struct VertexRelabeling {
+	std::vector<int> old_id;
+	//old_id[i] is old number of vertex i of relabeled graph
+	std::vector<int> new_id;
+	//new_id[v] is number of old vertex v in relabeled graph
+
+	VertexRelabeling(std::vector<int> order) : old_id(std::move(order)), new_id(old_id.size()) {
+		//order is permutation: vertices of old graph in new order
+		for (size_t i = 0; i < old_id.size(); ++i) {
+			new_id[old_id[i]] = i;
+		}
+	}
+
+	template <typename T>
+	std::vector<T> to_old(const std::vector<T>& values) const {
+		//values of vertices of relabeled graph by old numbers of vertices
+		//vertex numbers inside values are not changed, translate them by old_id
+		std::vector<T> answer(values.size());
+		for (size_t i = 0; i < values.size(); ++i) {
+			answer[old_id[i]] = values[i];
+		}
+		return answer;
+	}
+};
+
+template <typename Vertex, storage_type storage>
+VertexRelabeling makeRelabeling(const Graph<Vertex, storage>& graph, reorder_type type) {
+	//permutation of vertices which makes neighbours close in memory, see reorder_type
+	int N = graph.N;
+	std::vector<int> order;
+	order.reserve(N);
+	auto degree = [&graph](int v) {
+		return graph.neighbours(v).size();
+	};
+
+	if (type == degree_order) {
+		for (int v = 0; v < N; ++v) {
+			order.push_back(v);
+		}
+		std::stable_sort(order.begin(), order.end(), [&degree](int a, int b) {
+			return degree(a) > degree(b);
+		});
+		return VertexRelabeling(std::move(order));
+	}
+
+	std::vector<int> starts;
+	//first vertices of components, order itself is queue of BFS
+	for (int v = 0; v < N; ++v) {
+		starts.push_back(v);
+	}
+	if (type == reverse_cuthill_mckee) {
+		std::stable_sort(starts.begin(), starts.end(), [&degree](int a, int b) {
+			return degree(a) < degree(b);
+		});
+	}
+	std::vector<char> visited(N, 0);
+	std::vector<int> found;
+	for (int start : starts) {
+		if (visited[start])
+			continue;
+		visited[start] = 1;
+		order.push_back(start);
+		for (size_t head = order.size() - 1; head < order.size(); ++head) {
+			found.clear();
+			for (int to : graph.neighbours(order[head])) {
+				if (!visited[to]) {
+					visited[to] = 1;
+					found.push_back(to);
+				}
+			}
+			if (type == reverse_cuthill_mckee) {
+				std::stable_sort(found.begin(), found.end(), [&degree](int a, int b) {
+					return degree(a) < degree(b);
+				});
+			}
+			order.insert(order.end(), found.begin(), found.end());
+		}
+	}
+	if (type == reverse_cuthill_mckee)
+		std::reverse(order.begin(), order.end());
+	return VertexRelabeling(std::move(order));
+}
+
+template <typename Vertex, storage_type storage>
+void relabelGraph(const Graph<Vertex, storage>& graph, const VertexRelabeling& relabeling,
+		Graph<Vertex, csr>& relabeled, unsigned threads = 1) {
+	//delete all edges of second graph and make it copy of first graph with new numbers of vertices
+	//vertex i of relabeled graph is vertex relabeling.old_id[i] with its V, adjacency lists are sorted
+	int N = graph.N;
+	assert(relabeled.N == N);
+	assert(relabeling.old_id.size() == static_cast<size_t>(N));
+	relabeled.clear_pending_edges();
+	std::vector<size_t>& offsets = relabeled.offsets;
+	offsets.assign(N+1, 0);
+	for (int i = 0; i < N; ++i) {
+		offsets[i+1] = offsets[i] + graph.neighbours(relabeling.old_id[i]).size();
+	}
+	relabeled.edges.resize(offsets[N]);
+	parallelFor(N, threads, [&](size_t first, size_t last) {
+		for (size_t i = first; i < last; ++i) {
+			size_t position = offsets[i];
+			for (int to : graph.neighbours(relabeling.old_id[i])) {
+				relabeled.edges[position++] = relabeling.new_id[to];
+			}
+			std::sort(relabeled.edges.begin() + offsets[i], relabeled.edges.begin() + offsets[i+1]);
+			relabeled.V[i] = graph.V[relabeling.old_id[i]];
+		}
+	});
 }
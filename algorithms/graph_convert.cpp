@@ -0,0 +1,49 @@
+#include <vector>
+#include <iostream>
+
+#include "fast_io.h"
+#include "graph.h"
+
+//convert text graph "N M a1 b1 ... aM bM" (vertices from 1, as in topsort.cpp) from stdin
+//to binary graph file, which Graph<Vertex, mapped> opens without reading
+//edges are kept as they are: order of edges from one vertex, repeated edges and loops
+
+int main(int argc, char** argv) {
+	if (argc != 2) {
+		std::cerr << "usage: " << argv[0] << " output_file < text_graph\n";
+		return 1;
+	}
+
+	int N, M;
+	fast_io::In() >> N >> M;
+	if (N < 0 || M < 0) {
+		std::cerr << "bad number of vertices or edges\n";
+		return 1;
+	}
+	std::vector<std::pair<int, int>> edge_list(M);
+	std::vector<size_t> offsets(N+1, 0);
+	for (int i = 0; i < M; ++i) {
+		int a, b;
+		fast_io::In() >> a >> b;
+		--a;
+		--b;
+		if (a < 0 || a >= N || b < 0 || b >= N) {
+			std::cerr << "bad vertex in edge " << i+1 << '\n';
+			return 1;
+		}
+		edge_list[i] = {a, b};
+		++offsets[a+1];
+	}
+	for (int v = 0; v < N; ++v) {
+		offsets[v+1] += offsets[v];
+	}
+
+	std::vector<int> edges(M);
+	std::vector<size_t> position(offsets.begin(), offsets.end()-1);
+	for (const std::pair<int, int>& edge : edge_list) {
+		edges[position[edge.first]++] = edge.second;
+	}
+
+	writeGraphFile(argv[1], N, offsets, edges);
+	return 0;
+}
@@ -1,7 +1,8 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
-#include <iostream>
+
+#include "fast_io.h"
 
 template <typename Number>
 struct Point {
@@ -91,13 +92,13 @@ Number CrossProduct(const Point<Number>& left, const Point<Number>& right) {
 }
 
 template <typename Number>
-std::istream& operator>>(std::istream& is, Point<Number>& p) {
+fast_io::Reader& operator>>(fast_io::Reader& is, Point<Number>& p) {
     is >> p.x >> p.y;
     return is;
 }
 
 template <typename Number>
-std::ostream& operator<<(std::ostream& os, const Point<Number>& p) {
+fast_io::Writer& operator<<(fast_io::Writer& os, const Point<Number>& p) {
     os << p.x << ' ' << p.y;
     return os;
 }
@@ -173,7 +174,7 @@ void find_in_out_polygon(
         if (points[begin].y == points[end].y) {
             if (current_point.y == points[begin].y) {
                 if (point_between_two_points_H(current_point, points[begin], points[end])) {
-                    std::cout << "BOUNDARY\n";
+                    fast_io::Out() << "BOUNDARY\n";
                     return;
                 }
             }
@@ -183,7 +184,7 @@ void find_in_out_polygon(
             );
             if (pos == middle) {
                 if (point_between_two_points_V(current_point, points[begin], points[end])) {
-                    std::cout << "BOUNDARY\n";
+                    fast_io::Out() << "BOUNDARY\n";
                     return;
                 }
             }
@@ -199,24 +200,24 @@ void find_in_out_polygon(
     }
 
     if (left_segment_counter % 2 == 0) {
-        std::cout << "OUTSIDE\n";
+        fast_io::Out() << "OUTSIDE\n";
     } else {
-        std::cout << "INSIDE\n";
+        fast_io::Out() << "INSIDE\n";
     }
 }
 
 int main() {
     size_t n, m;
-    std::cin >> n >> m;
+    fast_io::In() >> n >> m;
 
     std::vector<Point<long long int>> points(n);
     for (size_t i = 0; i < n; ++i) {
-        std::cin >> points[i];
+        fast_io::In() >> points[i];
     }
 
     for (size_t k = 0; k < m; ++k) {
         Point<long long int> current_point;
-        std::cin >> current_point;
+        fast_io::In() >> current_point;
         find_in_out_polygon(points, current_point);
     }
 }
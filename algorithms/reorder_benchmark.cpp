@@ -0,0 +1,93 @@
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "graph.h"
+
+//traversals of road-like graph before and after relabeling of vertices
+//graph is side x side grid with both directions of edges, numbers of vertices are shuffled
+//as in input files, where they have nothing to do with positions
+//usage: reorder_benchmark [side]
+
+double secondsFrom(std::chrono::steady_clock::time_point begin) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+struct TraversalTimes {
+	double bfs;
+	double dfs;
+	std::vector<int> distance;
+};
+
+template <typename Vertex>
+TraversalTimes measure(const Graph<Vertex, csr>& graph, int source) {
+	TraversalTimes times;
+	auto begin = std::chrono::steady_clock::now();
+	times.distance = BFS(graph, graph, source, 1).distance;
+	//graph is symmetric, it is its own reverse graph
+	times.bfs = secondsFrom(begin);
+
+	begin = std::chrono::steady_clock::now();
+	DFSState<record_parent> state(graph.N);
+	DFS(graph, state, source);
+	times.dfs = secondsFrom(begin);
+	return times;
+}
+
+int main(int argc, char** argv) {
+	int side = argc > 1 ? std::atoi(argv[1]) : 2000;
+	int N = side * side;
+
+	std::vector<int> number(N);
+	for (int v = 0; v < N; ++v) {
+		number[v] = v;
+	}
+	std::shuffle(number.begin(), number.end(), std::mt19937(42));
+	std::vector<std::pair<int, int>> edge_list;
+	for (int row = 0; row < side; ++row) {
+		for (int column = 0; column < side; ++column) {
+			int v = number[row * side + column];
+			if (column + 1 < side) {
+				edge_list.push_back({v, number[row * side + column + 1]});
+				edge_list.push_back({number[row * side + column + 1], v});
+			}
+			if (row + 1 < side) {
+				edge_list.push_back({v, number[(row + 1) * side + column]});
+				edge_list.push_back({number[(row + 1) * side + column], v});
+			}
+		}
+	}
+	Graph<DFSVertex, csr> graph(N);
+	graph.build_from_edges(edge_list);
+	std::vector<std::pair<int, int>>().swap(edge_list);
+
+	int source = number[0];
+	TraversalTimes base = measure(graph, source);
+	std::printf("%d vertices, %zu edges\n", N, graph.edges.size());
+	std::printf("%-24s relabel %6.3f s  BFS %6.3f s  DFS %6.3f s\n", "input numbering", 0.0, base.bfs, base.dfs);
+
+	const std::pair<reorder_type, const char*> types[] = {
+		{bfs_order, "bfs order"},
+		{reverse_cuthill_mckee, "reverse Cuthill-McKee"},
+		{degree_order, "degree order"},
+	};
+	for (const auto& type : types) {
+		auto begin = std::chrono::steady_clock::now();
+		VertexRelabeling relabeling = makeRelabeling(graph, type.first);
+		Graph<DFSVertex, csr> relabeled(N);
+		relabelGraph(graph, relabeling, relabeled);
+		double relabel = secondsFrom(begin);
+
+		TraversalTimes times = measure(relabeled, relabeling.new_id[source]);
+		if (relabeling.to_old(times.distance) != base.distance) {
+			std::printf("%s: distances after relabeling differ from input numbering\n", type.second);
+			return 1;
+		}
+		std::printf("%-24s relabel %6.3f s  BFS %6.3f s  DFS %6.3f s  (x%.2f, x%.2f)\n", type.second, relabel,
+				times.bfs, times.dfs, base.bfs / times.bfs, base.dfs / times.dfs);
+	}
+	return 0;
+}
@@ -0,0 +1,59 @@
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <cassert>
+
+#include "fast_io.h"
+#include "graph.h"
+
+template <typename Vertex, storage_type storage>
+void printComponents(const Graph<Vertex, storage>& graph) {
+	//components are found in parallel, then condensation is sorted topologically
+	//and components are numbered in this order, so every edge goes to the same or bigger number
+	Graph<DFSVertex, csr> reverse_graph(graph.N);
+	makeReverseEdges(graph, reverse_graph);
+	StronglyConnectedComponents components = parallelStronglyConnectedComponents(graph, reverse_graph);
+	Graph<DFSVertex, csr> condensation(components.count);
+	makeCondensation(graph, components, condensation);
+	TopologicalOrder topological_order = topologicalSort(condensation);
+	assert(topological_order.is_acyclic());
+
+	std::vector<int> number(components.count);
+	for (int i = 0; i < components.count; ++i) {
+		number[topological_order.order[i]] = i;
+	}
+	fast_io::Out() << components.count << '\n';
+	for (int v = 0; v < graph.N; ++v) {
+		fast_io::Out() << number[components.component[v]] + 1 << ' ';
+	}
+	fast_io::Out() << '\n';
+}
+
+int main(int argc, char** argv) {
+	//input: N M and M edges, vertices are numbered from 1, or binary graph file as argument
+	//output: number of strongly connected components and component of every vertex
+	if (argc == 2) {
+		try {
+			Graph<DFSVertex, mapped> graph(argv[1], true);
+			printComponents(graph);
+		} catch (const std::runtime_error& error) {
+			std::cerr << error.what() << '\n';
+			return 1;
+		}
+		return 0;
+	}
+
+	int N, M;
+	fast_io::In() >> N >> M;
+	Graph<DFSVertex, csr> graph(N);
+	std::vector<std::pair<int, int>> edge_list(M);
+	for (int i = 0; i < M; ++i) {
+		int a, b;
+		fast_io::In() >> a >> b;
+		edge_list[i] = {a-1, b-1};
+	}
+	graph.build_from_edges(edge_list);
+	printComponents(graph);
+
+	return 0;
+}
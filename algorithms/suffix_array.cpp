@@ -1,8 +1,9 @@
 #include <algorithm>
-#include <iostream>
 #include <string>
 #include <vector>
 
+#include "fast_io.h"
+
 namespace constants {
 static const size_t kSigma = 26;
 }
@@ -107,7 +108,7 @@ class SuffixArray {
 
 int main() {
   std::string string_char;
-  std::cin >> string_char;
+  fast_io::In() >> string_char;
 
   std::vector<size_t> string;
   for (size_t i = 0; i < string_char.size(); ++i) {
@@ -120,7 +121,7 @@ int main() {
   suffix_array.IterationCountingSort();
 
   for (size_t i = 1; i < string.size(); ++i) {
-    std::cout << suffix_array.order[i] + 1 << ' ';
+    fast_io::Out() << suffix_array.order[i] + 1 << ' ';
   }
-  std::cout << '\n';
+  fast_io::Out() << '\n';
 }